@@ -1,20 +1,25 @@
 #include <cstdio>
-#include <cstring>
 #include <set>
+#include "../ch15/string_pool.h"
 
-struct CStringComparator {
-  bool operator()(const char* s1, const char* s2) const noexcept {
-    return std::strcmp(s1, s2) < 0;
+// Arguments are interned, so repeated ones collapse to the same id before they
+// reach the set, and the set compares the interned text through the pool.
+struct PooledComparator {
+  const StringPool& pool;
+  bool operator()(StringPool::Id a, StringPool::Id b) const noexcept {
+    return pool.view(a) < pool.view(b);
   }
 };
 
 int main(int argc, char** argv) {
-  std::set<const char*, CStringComparator> args;
+  StringPool pool;
+  std::set<StringPool::Id, PooledComparator> args{ PooledComparator{ pool } };
   for (size_t i{ 1 }; i < argc; i++) {
-    args.insert(argv[i]);
+    args.insert(pool.intern(argv[i]));
   }
   for (const auto& arg : args) {
-    printf("%s ", arg);
+    const auto text = pool.view(arg);
+    printf("%.*s ", static_cast<int>(text.size()), text.data());
   }
   printf("\n");
 }
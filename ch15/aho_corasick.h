@@ -0,0 +1,245 @@
+// ---------------------------------------------------------------------------------
+// Aho-Corasick: finding many literal patterns in one pass.
+//
+// Searching for each pattern in turn (or running one regex per pattern) costs
+// O(patterns × text). Aho-Corasick builds a trie of the patterns in which each
+// node also links to the longest proper suffix of its text that is a node too
+// (its "failure" link). Feeding the text through it one byte at a time finds
+// every occurrence of every pattern in O(text + matches).
+//
+// When the patterns use few distinct bytes the trie is compiled to a dense
+// transition table, one row per node and one column per byte used (all other
+// bytes share a column), so each text byte costs a single lookup. Otherwise
+// the table would be too large, and the nodes keep only their trie edges,
+// sorted, following failure links on a miss.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class AhoCorasick {
+public:
+  static constexpr size_t npos = SIZE_MAX;
+
+  // An occurrence of patterns[pattern] at text[position, position + length).
+  struct Match {
+    size_t position, length, pattern;
+
+    bool operator==(const Match& other) const {
+      return position == other.position && length == other.length && pattern == other.pattern;
+    }
+  };
+
+  // Patterns are numbered in order; a repeated pattern is reported under the
+  // number of its first occurrence.
+  template <typename Patterns>
+  explicit AhoCorasick(const Patterns& patterns) {
+    for (const auto& pattern : patterns) add(pattern);
+    build();
+  }
+
+  AhoCorasick(std::initializer_list<std::string_view> patterns) {
+    for (auto pattern : patterns) add(pattern);
+    build();
+  }
+
+  size_t pattern_count() const { return lengths.size(); }
+  bool is_dense() const { return !dense.empty(); }
+
+  // Calls fn with every match, overlapping ones included, in order of their
+  // end; matches ending at the same byte come longest first.
+  template <typename Fn>
+  void for_each_match(std::string_view text, Fn fn) const {
+    scan(text, [&](const Match& match) {
+      fn(match);
+      return false;
+    });
+  }
+
+  std::vector<Match> find_all(std::string_view text) const {
+    std::vector<Match> result;
+    for_each_match(text, [&](const Match& match) { result.push_back(match); });
+    return result;
+  }
+
+  bool contains(std::string_view text) const {
+    bool found{};
+    scan(text, [&](const Match&) { return found = true; });
+    return found;
+  }
+
+  // Replaces matches by replacements[pattern], building the result in one
+  // pass. Like POSIX leftmost-longest matching, it picks the leftmost match
+  // and, among those, the longest; the text after it is searched afresh.
+  std::string replace_all(std::string_view text,
+                          const std::vector<std::string>& replacements) const {
+    if (replacements.size() != pattern_count()) {
+      throw std::invalid_argument{ "AhoCorasick needs one replacement per pattern" };
+    }
+    return replace_all(text, [&](const Match& match) -> std::string_view {
+      return replacements[match.pattern];
+    });
+  }
+
+  std::string replace_all(std::string_view text, std::string_view replacement) const {
+    return replace_all(text, [&](const Match&) { return replacement; });
+  }
+
+  // Replaces each match by replacement(match).
+  template <typename Fn, typename = std::enable_if_t<std::is_invocable_v<Fn, const Match&>>>
+  std::string replace_all(std::string_view text, Fn replacement) const {
+    std::string result;
+    result.reserve(text.size());
+    size_t copied{};       // text[0, copied) is already in result.
+    Match candidate{ npos, 0, npos };
+    uint32_t state{};
+    const auto commit = [&] {
+      result.append(text.substr(copied, candidate.position - copied));
+      result.append(replacement(candidate));
+      copied = candidate.position + candidate.length;
+      candidate.position = npos;
+      state = 0;
+    };
+
+    for (size_t i{}; i < text.size(); i++) {
+      state = step(state, static_cast<unsigned char>(text[i]));
+      for (auto node = output_of(state); node; node = nodes[node].output) {
+        const auto length = lengths[nodes[node].pattern];
+        const auto position = i + 1 - length;
+        if (position < candidate.position ||
+            (position == candidate.position && length > candidate.length)) {
+          candidate = { position, length, nodes[node].pattern };
+        }
+      }
+      // No later match can start at or before the candidate: the current
+      // node's text is the longest suffix that could still grow into one.
+      if (candidate.position != npos && i + 1 - nodes[state].depth > candidate.position) {
+        commit();
+        i = copied - 1;
+      }
+      if (i + 1 == text.size() && candidate.position != npos) {
+        commit();
+        i = copied - 1;
+      }
+    }
+    result.append(text.substr(copied));
+    return result;
+  }
+
+private:
+  // Dense tables above this many entries (16 MiB) use the sorted edges instead.
+  static constexpr size_t dense_limit = 4 * 1024 * 1024;
+
+  struct Node {
+    uint32_t failure{};
+    uint32_t output{};          // Nearest node down the failure chain that ends a pattern.
+    uint32_t depth{};
+    size_t pattern{ npos };     // Pattern ending exactly here.
+    std::vector<std::pair<unsigned char, uint32_t>> edges;  // Sorted by byte.
+  };
+
+  void add(std::string_view pattern) {
+    if (pattern.empty()) throw std::invalid_argument{ "AhoCorasick patterns can't be empty" };
+    if (nodes.empty()) nodes.emplace_back();
+    uint32_t state{};
+    for (unsigned char c : pattern) {
+      auto child = edge(state, c);
+      if (!child) {
+        child = static_cast<uint32_t>(nodes.size());
+        auto& edges = nodes[state].edges;
+        edges.insert(std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0u)),
+                     { c, child });
+        nodes.push_back({});
+        nodes.back().depth = nodes[state].depth + 1;
+      }
+      state = child;
+    }
+    if (nodes[state].pattern == npos) nodes[state].pattern = lengths.size();
+    lengths.push_back(pattern.size());
+  }
+
+  // Child of state by c in the trie, or 0 (the root is never a child).
+  uint32_t edge(uint32_t state, unsigned char c) const {
+    const auto& edges = nodes[state].edges;
+    const auto found = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0u));
+    return found != edges.end() && found->first == c ? found->second : 0;
+  }
+
+  // Sets the failure and output links breadth first, so that a node's
+  // failure target is always done before it; then fills the dense table.
+  void build() {
+    if (nodes.empty()) nodes.emplace_back();
+    std::vector<uint32_t> order{ 0 };
+    for (size_t i{}; i < order.size(); i++) {
+      const auto state = order[i];
+      for (auto [c, child] : nodes[state].edges) {
+        if (state) {
+          auto failure = nodes[state].failure;
+          while (failure && !edge(failure, c)) failure = nodes[failure].failure;
+          nodes[child].failure = edge(failure, c);
+        }
+        const auto& failure = nodes[nodes[child].failure];
+        nodes[child].output = failure.pattern != npos ? nodes[child].failure : failure.output;
+        order.push_back(child);
+      }
+    }
+
+    for (const auto& node : nodes) {
+      for (auto [c, child] : node.edges) {
+        if (!column[c]) column[c] = static_cast<uint16_t>(++columns);
+      }
+    }
+    columns++;
+    if (nodes.size() * columns > dense_limit) return;
+    dense.assign(nodes.size() * columns, 0);
+    for (auto state : order) {
+      auto row = dense.begin() + state * columns;
+      if (state) {
+        const auto failure = dense.begin() + nodes[state].failure * columns;
+        std::copy(failure, failure + columns, row);
+      }
+      for (auto [c, child] : nodes[state].edges) row[column[c]] = child;
+    }
+  }
+
+  uint32_t step(uint32_t state, unsigned char c) const {
+    if (!dense.empty()) return dense[state * columns + column[c]];
+    while (true) {
+      if (const auto child = edge(state, c)) return child;
+      if (!state) return 0;
+      state = nodes[state].failure;
+    }
+  }
+
+  // First node of state's output chain: itself when it ends a pattern.
+  uint32_t output_of(uint32_t state) const {
+    return nodes[state].pattern != npos ? state : nodes[state].output;
+  }
+
+  // Calls fn with each match until it returns true.
+  template <typename Fn>
+  void scan(std::string_view text, Fn fn) const {
+    uint32_t state{};
+    for (size_t i{}; i < text.size(); i++) {
+      state = step(state, static_cast<unsigned char>(text[i]));
+      for (auto node = output_of(state); node; node = nodes[node].output) {
+        const auto length = lengths[nodes[node].pattern];
+        if (fn(Match{ i + 1 - length, length, nodes[node].pattern })) return;
+      }
+    }
+  }
+
+  std::vector<Node> nodes;
+  std::vector<size_t> lengths;   // Of each pattern, by number.
+  uint16_t column[256]{};        // Dense table column of each byte; 0 for unused bytes.
+  size_t columns{};
+  std::vector<uint32_t> dense;
+};
@@ -0,0 +1,134 @@
+// ---------------------------------------------------------------------------------
+// ASCII case conversion and case-insensitive search.
+//
+// std::toupper and std::tolower convert one int at a time through the locale.
+// For ASCII text a byte is a letter of the other case when it is in a 26-byte
+// range, and converting it flips bit 0x20, so AVX2 converts 32 bytes with an
+// add, a compare, an and and a xor. Bytes outside A-Z/a-z, UTF-8 ones
+// included, are left alone, which is what the "C" locale does.
+//
+// find_ignoring_case is the case-folding analogue of memmem: it compares the
+// folded first and last bytes of the needle against 32 positions at once, and
+// only checks the whole needle where both match.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <immintrin.h>
+
+namespace AsciiCase {
+
+namespace detail {
+
+constexpr char convert(char c, char first) {
+  return static_cast<unsigned char>(c - first) < 26 ? c ^ 0x20 : c;
+}
+
+// Flips bit 0x20 of the bytes in [first, first + 26). Adding 0x80 - first
+// moves that range to the bottom of the signed bytes, where one comparison
+// finds it.
+__attribute__((target("avx2")))
+inline __m256i convert(__m256i block, char first) {
+  const auto shifted = _mm256_add_epi8(block, _mm256_set1_epi8(static_cast<char>(0x80 - first)));
+  const auto in_range = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_xor_si256(block, _mm256_and_si256(in_range, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+inline void convert_avx2(const char* in, size_t n, char* out, char first) {
+  size_t i{};
+  for (; i + 32 <= n; i += 32) {
+    const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), convert(block, first));
+  }
+  for (; i < n; i++) out[i] = convert(in[i], first);
+}
+
+// Writes in with the letters from first to first + 25 switched to the other
+// case; out may be in.data() to convert in place.
+inline void convert(std::string_view in, char* out, char first) {
+  if (in.size() >= 32 && __builtin_cpu_supports("avx2")) {
+    convert_avx2(in.data(), in.size(), out, first);
+    return;
+  }
+  for (size_t i{}; i < in.size(); i++) out[i] = convert(in[i], first);
+}
+
+}
+
+constexpr char to_lower(char c) { return detail::convert(c, 'A'); }
+constexpr char to_upper(char c) { return detail::convert(c, 'a'); }
+
+// out must have room for in.size() bytes, and may be in.data().
+inline void to_lower(std::string_view in, char* out) { detail::convert(in, out, 'A'); }
+inline void to_upper(std::string_view in, char* out) { detail::convert(in, out, 'a'); }
+
+inline void to_lower(std::string& str) { to_lower(str, str.data()); }
+inline void to_upper(std::string& str) { to_upper(str, str.data()); }
+
+// Case folding, for comparisons: ASCII folds to lower case.
+inline std::string fold(std::string_view str) {
+  std::string result(str.size(), '\0');
+  to_lower(str, result.data());
+  return result;
+}
+
+inline bool equal_ignoring_case(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i{}; i < a.size(); i++) {
+    if (to_lower(a[i]) != to_lower(b[i])) return false;
+  }
+  return true;
+}
+
+namespace detail {
+
+__attribute__((target("avx2")))
+inline size_t find_ignoring_case_avx2(std::string_view haystack, std::string_view needle,
+                                      size_t pos) {
+  const auto first = _mm256_set1_epi8(to_lower(needle.front()));
+  const auto last = _mm256_set1_epi8(to_lower(needle.back()));
+  const auto last_offset = needle.size() - 1;
+  for (; pos + last_offset + 32 <= haystack.size(); pos += 32) {
+    const auto* p = haystack.data() + pos;
+    const auto front = convert(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), 'A');
+    const auto back = convert(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + last_offset)), 'A');
+    auto candidates = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+      _mm256_cmpeq_epi8(front, first), _mm256_cmpeq_epi8(back, last))));
+    while (candidates) {
+      const auto candidate = pos + __builtin_ctz(candidates);
+      if (equal_ignoring_case(haystack.substr(candidate, needle.size()), needle)) {
+        return candidate;
+      }
+      candidates &= candidates - 1;
+    }
+  }
+  for (; pos + needle.size() <= haystack.size(); pos++) {
+    if (equal_ignoring_case(haystack.substr(pos, needle.size()), needle)) return pos;
+  }
+  return std::string_view::npos;
+}
+
+}
+
+// Like std::string_view::find, with ASCII letters matching either case.
+inline size_t find_ignoring_case(std::string_view haystack, std::string_view needle,
+                                 size_t pos = 0) {
+  if (pos > haystack.size() || needle.size() > haystack.size() - pos) {
+    return std::string_view::npos;
+  }
+  if (needle.empty()) return pos;
+  if (__builtin_cpu_supports("avx2")) {
+    return detail::find_ignoring_case_avx2(haystack, needle, pos);
+  }
+  for (; pos + needle.size() <= haystack.size(); pos++) {
+    if (equal_ignoring_case(haystack.substr(pos, needle.size()), needle)) return pos;
+  }
+  return std::string_view::npos;
+}
+
+}
@@ -261,6 +261,45 @@ TEST_CASE("std::string find_first_of variations") {
   }
 }
 
+// find and its variations are case-sensitive. ascii_case.h has case
+// conversion and a case-insensitive find for ASCII text.
+
+#include <cctype>
+#include "ascii_case.h"
+
+TEST_CASE("AsciiCase") {
+  std::string sentence("I am a Zizzer-Zazzer-Zuzz as you can plainly see. [@`{] \xC3\x89t\xC3\xA9");
+  SECTION("converts letters only") {
+    auto upper{ sentence }, lower{ sentence };
+    AsciiCase::to_upper(upper);
+    AsciiCase::to_lower(lower);
+    REQUIRE(upper == "I AM A ZIZZER-ZAZZER-ZUZZ AS YOU CAN PLAINLY SEE. [@`{] \xC3\x89T\xC3\xA9");
+    REQUIRE(lower == "i am a zizzer-zazzer-zuzz as you can plainly see. [@`{] \xC3\x89t\xC3\xA9");
+    REQUIRE(AsciiCase::fold("ZaZ") == "zaz");
+  }
+  SECTION("agrees with std::toupper and std::tolower on every byte") {
+    std::string bytes;
+    for (int c{}; c < 256; c++) bytes.push_back(static_cast<char>(c));
+    auto upper{ bytes }, lower{ bytes };
+    AsciiCase::to_upper(upper);
+    AsciiCase::to_lower(lower);
+    for (int c{}; c < 256; c++) {
+      REQUIRE(static_cast<unsigned char>(upper[c]) == std::toupper(c));
+      REQUIRE(static_cast<unsigned char>(lower[c]) == std::tolower(c));
+    }
+  }
+  SECTION("finds substrings ignoring case") {
+    REQUIRE(AsciiCase::find_ignoring_case(sentence, "zAZ") == 14); // (Z)azzer
+    REQUIRE(AsciiCase::find_ignoring_case(sentence, "zuzz", 15) == 21);
+    REQUIRE(AsciiCase::find_ignoring_case(sentence, "PLAINLY SEE") == 37);
+    REQUIRE(AsciiCase::find_ignoring_case(sentence, "zuzzz") == std::string::npos);
+    REQUIRE(AsciiCase::find_ignoring_case(sentence, "") == 0);
+    std::string haystack(1000, 'a');
+    haystack += "aB";
+    REQUIRE(AsciiCase::find_ignoring_case(haystack, "Ab") == 1000);
+  }
+}
+
 // Numeric conversions
 
 TEST_CASE("STL string conversion function") {
@@ -294,6 +333,236 @@ TEST_CASE("STL string conversion function") {
   }
 }
 
+// std::from_chars and std::to_chars (in <charconv>) are the locale-free,
+// non-throwing primitives under these. number_parsing.h has faster base-10
+// versions with the same interface, plus a bulk parser.
+
+#include "number_parsing.h"
+
+TEST_CASE("NumberParsing::from_chars") {
+  using namespace std::literals::string_view_literals;
+  SECTION("parses integers 8 digits at a time") {
+    const auto text = "8675309123456789"sv;
+    uint64_t value{};
+    const auto [end, error] = NumberParsing::from_chars(text.data(), text.data() + text.size(), value);
+    REQUIRE(error == std::errc{});
+    REQUIRE(end == text.data() + text.size());
+    REQUIRE(value == 8675309123456789);
+  }
+  SECTION("stops at the first non-digit") {
+    const auto text = "42six"sv;
+    int value{};
+    const auto [end, error] = NumberParsing::from_chars(text.data(), text.data() + text.size(), value);
+    REQUIRE(value == 42);
+    REQUIRE(end - text.data() == 2);
+  }
+  SECTION("reports integers out of range") {
+    const auto text = "1099511627776"sv;
+    int value{};
+    const auto [end, error] = NumberParsing::from_chars(text.data(), text.data() + text.size(), value);
+    REQUIRE(error == std::errc::result_out_of_range);
+  }
+  SECTION("parses doubles exactly like std::from_chars") {
+    for (auto text : { "2.7182818"sv, "-0.1"sv, "6.0221415e-23"sv, "1e308"sv,
+                       "2.2250738585072014e-308"sv, "12345678901234567890123"sv }) {
+      double fast{}, standard{};
+      NumberParsing::from_chars(text.data(), text.data() + text.size(), fast);
+      std::from_chars(text.data(), text.data() + text.size(), standard);
+      REQUIRE(fast == standard);
+    }
+  }
+}
+
+TEST_CASE("NumberParsing::parse") {
+  using namespace std::literals::string_literals;
+  SECTION("parses like stoi and stod") {
+    REQUIRE(NumberParsing::parse<int>("8675309") == 8675309);
+    REQUIRE(NumberParsing::parse<double>("2.7182818") == Approx(2.7182818));
+  }
+  SECTION("throws like stoi") {
+    REQUIRE_THROWS_AS(NumberParsing::parse<int>("1099511627776"), std::out_of_range);
+    REQUIRE_THROWS_AS(NumberParsing::parse<int>("42six"), std::invalid_argument);
+  }
+  SECTION("to_string round-trips") {
+    REQUIRE(NumberParsing::to_string(8675309) == "8675309"s);
+    REQUIRE(NumberParsing::to_string(0.1) == "0.1"s);
+  }
+}
+
+TEST_CASE("NumberParsing::parse_lines") {
+  SECTION("parses a newline-separated buffer") {
+    const auto numbers = NumberParsing::parse_lines<int>("-54\n203\r\n\n 9000 \n0\n");
+    REQUIRE(numbers == std::vector<int>{ -54, 203, 9000, 0 });
+  }
+  SECTION("parses doubles") {
+    const auto numbers = NumberParsing::parse_lines<double>("1.5\n-2e3\n");
+    REQUIRE(numbers == std::vector<double>{ 1.5, -2000.0 });
+  }
+  SECTION("rejects malformed lines") {
+    REQUIRE_THROWS_AS(NumberParsing::parse_lines<int>("1\n2 3\n"), std::invalid_argument);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Rope: a string made of chunks in a balanced tree, for large, edit-heavy
+// buffers. Implemented in rope.h; rope_bench.cpp compares it with std::string.
+
+#include "rope.h"
+
+TEST_CASE("Rope supports the std::string edits") {
+  Rope word("substitution");
+  SECTION("insert") {
+    word.insert(3, "con");
+    REQUIRE(word == "subconstitution");
+  }
+  SECTION("erase") {
+    word.erase(8);
+    REQUIRE(word == "substitu");
+  }
+  SECTION("replace") {
+    word.replace(3, 6, "vers");
+    REQUIRE(word == "subversion");
+  }
+  SECTION("substr") {
+    REQUIRE(word.substr(3, 5) == "stitu");
+    REQUIRE(word == "substitution");
+  }
+  SECTION("find") {
+    REQUIRE(word.find("tit") == 4);
+    REQUIRE(word.find("t", 5) == 6);
+    REQUIRE(word.find("x") == Rope::npos);
+  }
+}
+
+TEST_CASE("Rope matches std::string on buffers spanning many chunks") {
+  std::string text;
+  for (size_t i{}; text.size() < 10 * Rope::chunk_size; i++) {
+    text += "line " + std::to_string(i) + "\n";
+  }
+  Rope rope(text);
+  REQUIRE(rope.size() == text.size());
+
+  SECTION("edits far apart") {
+    rope.insert(Rope::chunk_size * 3 + 7, "inserted");
+    text.insert(Rope::chunk_size * 3 + 7, "inserted");
+    rope.erase(100, Rope::chunk_size * 2);
+    text.erase(100, Rope::chunk_size * 2);
+    REQUIRE(rope.to_string() == text);
+    REQUIRE(rope[text.size() - 2] == text[text.size() - 2]);
+  }
+  SECTION("find across a chunk boundary") {
+    const auto needle = text.substr(Rope::chunk_size - 3, 8);
+    REQUIRE(rope.find(needle) == text.find(needle));
+  }
+  SECTION("chunks are contiguous views of the text") {
+    size_t offset{};
+    for (auto chunk : rope.chunks()) {
+      REQUIRE(chunk.size() <= Rope::chunk_size);
+      REQUIRE(chunk == std::string_view(text).substr(offset, chunk.size()));
+      offset += chunk.size();
+    }
+    REQUIRE(offset == text.size());
+  }
+  SECTION("substr shares chunks and leaves the original untouched") {
+    auto middle = rope.substr(5000, 20000);
+    middle.erase(0, 10);
+    REQUIRE(middle == std::string_view(text).substr(5010, 19990));
+    REQUIRE(rope.to_string() == text);
+  }
+  SECTION("small edits don't shred the rope into tiny chunks") {
+    for (size_t i{}; i < 2000; i++) {
+      const auto pos = i * 7919 % (text.size() - 20);
+      rope.erase(pos, 12);
+      text.erase(pos, 12);
+      rope.insert(i * 104729 % text.size(), "0123456789");
+      text.insert(i * 104729 % text.size(), "0123456789");
+    }
+    REQUIRE(rope.to_string() == text);
+    size_t chunks{};
+    for ([[maybe_unused]] auto chunk : rope.chunks()) chunks++;
+    REQUIRE(chunks <= 4 * text.size() / Rope::chunk_size);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// String arenas and interning: storing many small strings without one
+// allocation each. Implemented in string_pool.h.
+
+#include "string_pool.h"
+
+TEST_CASE("StringArena stores strings back to back") {
+  StringArena arena{ 16 };
+  const auto first = arena.store("hobbits");
+  const auto second = arena.store("dwarves");
+  REQUIRE(first == "hobbits");
+  REQUIRE(second == "dwarves");
+  REQUIRE(second.data() == first.data() + first.size());
+  SECTION("and moves on to a new block when one is full") {
+    const auto third = arena.store("elves");
+    REQUIRE(third == "elves");
+    REQUIRE(first == "hobbits");
+  }
+  SECTION("and hands its blocks over when moved, leaving the old arena empty") {
+    auto moved{ std::move(arena) };
+    REQUIRE(arena.bytes_reserved() == 0);
+    const auto fourth = arena.store("ents");
+    const auto fifth = moved.store("ok");
+    REQUIRE(fourth == "ents");
+    // The rest of the block it was given.
+    REQUIRE((fifth.data() == second.data() + second.size()));
+    REQUIRE(first == "hobbits");
+    REQUIRE(second == "dwarves");
+  }
+}
+
+TEST_CASE("StringArena::Builder") {
+  StringArena arena{ 8 };
+  auto builder = arena.builder();
+  SECTION("appends in place") {
+    builder.append("Bilbo").push_back(' ').append("Baggins");
+    REQUIRE(builder.finish() == "Bilbo Baggins");
+  }
+  SECTION("builds several strings in a row") {
+    const auto first = builder.append("Frodo").finish();
+    const auto second = builder.append("Sam").finish();
+    REQUIRE(first == "Frodo");
+    REQUIRE(second == "Sam");
+  }
+}
+
+TEST_CASE("StringPool interns") {
+  StringPool pool;
+  const auto gandalf = pool.intern("Gandalf");
+  const auto saruman = pool.intern("Saruman");
+  SECTION("equal strings to equal ids") {
+    std::string grey{ "Gandalf" };
+    REQUIRE(pool.intern(grey) == gandalf);
+    REQUIRE(gandalf != saruman);
+    REQUIRE(pool.size() == 2);
+  }
+  SECTION("and gives the text back as a string_view") {
+    REQUIRE(pool.view(gandalf) == "Gandalf");
+    REQUIRE(pool[saruman] == "Saruman");
+  }
+  SECTION("and finds ids without interning") {
+    REQUIRE(pool.find("Saruman") == saruman);
+    REQUIRE(pool.find("Radagast") == StringPool::npos);
+  }
+  SECTION("strings from a builder, reusing the bytes of duplicates") {
+    auto builder = pool.builder();
+    builder.append("Gan").append("dalf");
+    REQUIRE(pool.intern(builder) == gandalf);
+    builder.append("Radagast");
+    const auto radagast = pool.intern(builder);
+    REQUIRE(pool.view(radagast) == "Radagast");
+  }
+  SECTION("many strings") {
+    for (int i{}; i < 10000; i++) pool.intern(std::to_string(i));
+    REQUIRE(pool.size() == 10002);
+    REQUIRE(pool.view(pool.find("1234")) == "1234");
+  }
+}
+
 // ---------------------------------------------------------------------------------
 // String view: drop-in replacement for const string&.
 // Its main usage is when passing a string literal as a parameter for a
@@ -348,6 +617,67 @@ size_t count_vees(std::string_view my_view) {
   return result;
 }
 
+// ---------------------------------------------------------------------------------
+// UTF-8: a std::string or std::string_view is a sequence of bytes, and any
+// character (code point) past ASCII takes two to four of them. utf8.h
+// validates, decodes and classifies them.
+//
+// count_vees is right on UTF-8 as it is: bytes below 0x80 never occur inside
+// a multi-byte sequence. For other code points, Utf8::count searches for their
+// encoding.
+
+#include "utf8.h"
+
+TEST_CASE("Utf8 validates") {
+  REQUIRE(Utf8::validate("pr\xC3\xA9view \xE2\x82\xAC \xF0\x9F\x98\x80"));  // préview € 😀
+  REQUIRE(Utf8::is_ascii("previewing"));
+  REQUIRE_FALSE(Utf8::is_ascii("pr\xC3\xA9view"));
+  SECTION("rejecting malformed sequences") {
+    for (std::string_view bad : { "\x80", "\xC3", "\xC0\xAF", "\xE0\x80\x80", "\xED\xA0\x80",
+                                  "\xF4\x90\x80\x80", "\xFF", "\xE2\x82" }) {
+      std::string text(100, 'v');
+      text.insert(40, bad);
+      REQUIRE_FALSE(Utf8::validate(text));
+      REQUIRE_FALSE(Utf8::validate(bad));
+    }
+  }
+}
+
+TEST_CASE("Utf8 decodes code points") {
+  std::string_view text("v\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xFF");
+  const std::u32string expected{ U'v', U'\u00E9', U'\u20AC', U'\U0001F600', Utf8::replacement };
+  REQUIRE(std::u32string(Utf8::CodePoints{ text }.begin(), Utf8::CodePoints{ text }.end()) == expected);
+  REQUIRE(Utf8::to_utf32(text) == expected);
+  REQUIRE(Utf8::length("pr\xC3\xA9view") == 7);
+  REQUIRE(Utf8::encode(U'\u20AC') == "\xE2\x82\xAC");
+  REQUIRE(Utf8::count("vv\xC3\xA9v\xC3\xA9", U'\u00E9') == 2);
+  REQUIRE(count_vees("vv\xC3\xA9v\xC3\xA9") == 3);
+  SECTION("with ASCII runs widened in blocks") {
+    std::string long_text(100, 'v');
+    long_text += "\xC3\xA9";
+    long_text.append(100, 'w');
+    const auto code_points = Utf8::to_utf32(long_text);
+    REQUIRE(code_points.size() == 201);
+    REQUIRE(code_points[99] == U'v');
+    REQUIRE(code_points[100] == U'\u00E9');
+    REQUIRE(code_points[200] == U'w');
+  }
+  SECTION("with case mapping beyond ASCII") {
+    REQUIRE(Utf8::to_lower(U'\u00C9') == U'\u00E9');     // É
+    REQUIRE(Utf8::to_upper(U'\u03C9') == U'\u03A9');     // ω
+    REQUIRE(Utf8::to_lower(U'\u0416') == U'\u0436');     // Ж
+    REQUIRE(Utf8::to_upper(U'\u0142') == U'\u0141');     // ł
+    REQUIRE(Utf8::to_lower(U'\u0130') == U'i');          // İ
+    REQUIRE(Utf8::to_upper(U'\u0130') == U'\u0130');
+    REQUIRE(Utf8::to_upper(U'\u0131') == U'I');          // ı
+    REQUIRE(Utf8::to_lower(U'\u0131') == U'\u0131');
+    REQUIRE(Utf8::to_upper(U'\u03C2') == U'\u03A3');     // ς
+    REQUIRE(Utf8::to_lower(U'\u03A3') == U'\u03C3');     // Σ
+    REQUIRE(Utf8::is_alpha(U'\u00E9'));
+    REQUIRE_FALSE(Utf8::is_alpha(U'\u2019'));            // ’
+  }
+}
+
 // ---------------------------------------------------------------------------------
 // Regex: Strings that define search patterns.
 
@@ -399,6 +729,47 @@ TEST_CASE("std::regex_replace") {
   REQUIRE(result == "q_____ng _nd c_____ng _n __t_p__");
 }
 
+// One regex per pattern makes finding many literal patterns O(patterns × text).
+// AhoCorasick (aho_corasick.h) finds all of them in a single pass.
+
+#include "aho_corasick.h"
+
+TEST_CASE("AhoCorasick") {
+  const AhoCorasick matcher{ "he", "she", "his", "hers" };
+  REQUIRE(matcher.is_dense());
+  SECTION("finds every match, overlapping ones included") {
+    const std::vector<AhoCorasick::Match> expected{ { 1, 3, 1 }, { 2, 2, 0 }, { 2, 4, 3 } };
+    REQUIRE(matcher.find_all("ushers") == expected);
+    REQUIRE(matcher.contains("this"));
+    REQUIRE_FALSE(matcher.contains("ships"));
+  }
+  SECTION("replaces the leftmost-longest matches in one pass") {
+    REQUIRE(matcher.replace_all("ushers and his hens", "_") == "u_rs and _ _ns");
+    REQUIRE(matcher.replace_all("she", { "1", "2", "3", "4" }) == "2");
+  }
+  SECTION("agrees with std::regex_replace on an alternation") {
+    const AhoCorasick words{ "queue", "queueing", "and", "co", "cooee" };
+    std::regex regex{ "queueing|queue|cooee|and|co" };
+    std::string phrase("queueing and cooeeing in eutopia, queue cocooee");
+    REQUIRE(words.replace_all(phrase, "_") == std::regex_replace(phrase, regex, "_"));
+  }
+  SECTION("uses sorted edges for large alphabets") {
+    std::vector<std::string> patterns;
+    for (int i{}; i < 20'000; i++) patterns.push_back(std::to_string(i * 7919) + char(i % 200 + 40));
+    const AhoCorasick many{ patterns };
+    REQUIRE_FALSE(many.is_dense());
+    const auto text = "x" + patterns[123] + "y" + patterns[19'999];
+    size_t found{};
+    many.for_each_match(text, [&](const AhoCorasick::Match& match) {
+      found += match.pattern == 123 || match.pattern == 19'999;
+    });
+    REQUIRE(found == 2);
+  }
+  SECTION("rejects empty patterns") {
+    REQUIRE_THROWS_AS(AhoCorasick({ "a", "" }), std::invalid_argument);
+  }
+}
+
 // ---------------------------------------------------------------------------------
 // Boost String Algorithms
 // TODO: cover this section. On first read, I found it too complicated and
@@ -424,27 +795,117 @@ TEST_CASE("boost::tokenizer splits token-delimited strings") {
   REQUIRE(*itr == " Panama!");
 }
 
+// Each boost::tokenizer token is a new std::string. Tokenizer (tokenizer.h)
+// yields std::string_views into the input instead.
+
+#include "tokenizer.h"
+
+TEST_CASE("Tokenizer splits token-delimited strings without copying") {
+  std::string palindrome("A man, a plan, a canal, Panama!");
+  Tokenizer tokens{ palindrome, "," };
+  auto itr = tokens.begin();
+  REQUIRE(*itr == "A man");
+  REQUIRE(itr->data() == palindrome.data());
+  itr++;
+  REQUIRE(*itr == " a plan");
+  itr++;
+  REQUIRE(*itr == " a canal");
+  itr++;
+  REQUIRE(*itr == " Panama!");
+  itr++;
+  REQUIRE(itr == tokens.end());
+}
+
+TEST_CASE("Tokenizer") {
+  SECTION("skips runs of several delimiters, like boost::char_separator") {
+    std::vector<std::string_view> words;
+    for (auto word : Tokenizer{ "  queueing, and;cooeeing ", " ,;" }) words.push_back(word);
+    REQUIRE(words == std::vector<std::string_view>{ "queueing", "and", "cooeeing" });
+  }
+  SECTION("for_each agrees with iteration on long texts") {
+    std::string text;
+    for (int i{}; i < 1000; i++) text += std::to_string(i * i) + (i % 3 ? " " : ";;");
+    Tokenizer tokens{ text, " ;" };
+    std::vector<std::string_view> iterated(tokens.begin(), tokens.end()), visited;
+    tokens.for_each([&](std::string_view token) { visited.push_back(token); });
+    REQUIRE(iterated.size() == 1000);
+    REQUIRE(visited == iterated);
+  }
+  SECTION("reads CSV fields, keeping empty and quoted ones") {
+    std::vector<std::string_view> fields;
+    for (auto field : Tokenizer::csv(R"(NJ,,"07936, ""Zip""",)")) fields.push_back(field);
+    REQUIRE(fields == std::vector<std::string_view>{ "NJ", "", R"(07936, ""Zip"")", "" });
+    REQUIRE(Tokenizer::unescape(fields[2]) == R"(07936, "Zip")");
+  }
+  SECTION("splits in parallel without cutting tokens or quotes") {
+    std::string csv;
+    for (int i{}; i < 100'000; i++) csv += i % 7 ? std::to_string(i) + "," : R"("a,""b",)";
+    const auto tokens = Tokenizer::csv(csv);
+    const std::vector<std::string_view> serial(tokens.begin(), tokens.end());
+    REQUIRE(tokens.parallel(4) == serial);
+  }
+  SECTION("keeps the empty field after a delimiter that ends the text") {
+    std::string csv(200'000, 'x');
+    csv[50] = csv.back() = ',';
+    const auto tokens = Tokenizer::csv(csv);
+    std::vector<std::string_view> serial;
+    tokens.for_each([&](std::string_view token) { serial.push_back(token); });
+    REQUIRE(serial.size() == 3);
+    REQUIRE(tokens.parallel(2) == serial);
+    REQUIRE(Tokenizer::csv("").parallel(2).empty());
+  }
+}
+
 // ---------------------------------------------------------------------------------
 // Exercises
 
 #include <cctype>
 
 // Exercise 15-1
-// Implemented in ex15_1.cpp
+// Implemented in ex15_1.cpp, with the histogram in ../ch16/alpha_histogram.h.
+
+#include "../ch16/alpha_histogram.h"
+
+TEST_CASE("AlphaHistogram") {
+  std::string text;
+  for (int i{}; i < 10'000; i++) text += "The quick brown fox jumps over the lazy dog. ";
+  AlphaHistogram hist;
+  hist.ingest(text);
+  REQUIRE(hist.count('O') == 40'000);
+  REQUIRE(hist.count('T') == 20'000);
+  REQUIRE(hist.count('Z') == 10'000);
+  SECTION("counts UTF-8 letters by code point") {
+    hist.ingest("\xC3\xA9t\xC3\xA9 \xC3\x89T\xC3\x89");  // été ÉTÉ
+    REQUIRE(hist.count(U'\u00C9') == 4);
+    REQUIRE(hist.count('T') == 20'002);
+  }
+  SECTION("gives the same counts in parallel") {
+    text.insert(text.size() / 2, "\xC3\xA9");
+    AlphaHistogram parallel;
+    parallel.ingest(text, 4);
+    hist.ingest("\xC3\xA9");
+    hist.for_each([&](char32_t c, size_t n) { REQUIRE(parallel.count(c) == n); });
+  }
+}
 
 // Rest of exercises are implemented as functions for simplicity.
 
 // Exercise 15-2
 
-bool is_palindrome(std::string_view str) {
-    for (size_t i = 0, j = str.length() - 1; i < j; ++i, --j) {
-        while (i < j && !std::isalnum(str[i])) {
+// std::isalnum and std::tolower take an int that must be representable as an
+// unsigned char, so chars are converted first. j is one past the back cursor,
+// so it can't wrap around below zero on inputs like "a,".
+bool is_palindrome_scalar(std::string_view str) {
+    const auto alnum = [](char c) { return std::isalnum(static_cast<unsigned char>(c)); };
+    const auto lower = [](char c) { return std::tolower(static_cast<unsigned char>(c)); };
+    for (size_t i = 0, j = str.length(); i < j; ++i, --j) {
+        while (i < j && !alnum(str[i])) {
             ++i;
         }
-        while (i < j && !std::isalnum(str[j])) {
+        while (i < j && !alnum(str[j - 1])) {
             --j;
         }
-        if (std::tolower(str[i]) != std::tolower(str[j])) {
+        if (i < j && lower(str[i]) != lower(str[j - 1])) {
             return false;
         }
     }
@@ -452,6 +913,144 @@ bool is_palindrome(std::string_view str) {
     return true;
 }
 
+// An ASCII fast path for long inputs. Blocks of 32 bytes are loaded from the
+// front, and reversed blocks from the back. Each block's alphanumerics are
+// compacted with shuffle masks and case-folded with a bitwise or, then the
+// two streams are compared a vector at a time. The scalar version handles
+// anything that isn't ASCII.
+
+#include <array>
+#include <cstring>
+#include <optional>
+#include <immintrin.h>
+
+// For each 8-bit mask, the pshufb control that moves the selected bytes of an
+// 8-byte group to its front.
+constexpr std::array<uint64_t, 256> make_compaction_table() {
+    std::array<uint64_t, 256> table{};
+    for (unsigned mask = 0; mask < 256; mask++) {
+        uint64_t control = 0x8080808080808080;
+        int out = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (mask & (1u << bit)) {
+                control &= ~(uint64_t{ 0xFF } << (8 * out));
+                control |= uint64_t(bit) << (8 * out);
+                out++;
+            }
+        }
+        table[mask] = control;
+    }
+    return table;
+}
+
+constexpr auto compaction_table = make_compaction_table();
+
+// Appends the case-folded alphanumerics of block to out, returning how many.
+// out needs 32 bytes of room past the returned count.
+__attribute__((target("avx2")))
+size_t compact_alnum(__m256i block, char* out) {
+    const auto folded = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+    const auto is_digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+    const auto is_letter = _mm256_and_si256(
+        _mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter));
+
+    size_t count{};
+    for (int half = 0; half < 2; half++) {
+        const auto bytes = half ? _mm256_extracti128_si256(folded, 1)
+                                : _mm256_castsi256_si128(folded);
+        const unsigned low = (mask >> (16 * half)) & 0xFF;
+        const unsigned high = (mask >> (16 * half + 8)) & 0xFF;
+        const auto control = _mm_set_epi64x(compaction_table[high] + 0x0808080808080808,
+                                            compaction_table[low]);
+        // Bytes the table zeroes (0x80) stay 0x80 + 8 = 0x88: still zeroed.
+        const auto packed = _mm_shuffle_epi8(bytes, control);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + count), packed);
+        count += __builtin_popcount(low);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + count),
+                         _mm_unpackhi_epi64(packed, packed));
+        count += __builtin_popcount(high);
+    }
+    return count;
+}
+
+// Returns nullopt when str isn't ASCII.
+__attribute__((target("avx2")))
+std::optional<bool> is_palindrome_avx2(std::string_view str) {
+    const auto reverse_lanes = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    // Normalized characters read from each end but not yet compared. The back
+    // ones are in reverse order, so front[k] must equal back[k].
+    char front[128], back[128];
+    size_t front_count{}, back_count{};
+    const char* lo = str.data();
+    const char* hi = str.data() + str.size();
+
+    while (hi - lo >= 64) {
+        if (front_count < 32) {
+            const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo));
+            if (_mm256_movemask_epi8(block)) return std::nullopt;
+            front_count += compact_alnum(block, front + front_count);
+            lo += 32;
+        }
+        if (back_count < 32) {
+            auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi - 32));
+            if (_mm256_movemask_epi8(block)) return std::nullopt;
+            block = _mm256_shuffle_epi8(block, reverse_lanes);
+            block = _mm256_permute2x128_si256(block, block, 1);
+            back_count += compact_alnum(block, back + back_count);
+            hi -= 32;
+        }
+        const auto common = std::min(front_count, back_count);
+        size_t k{};
+        for (; k + 32 <= common; k += 32) {
+            const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(front + k));
+            const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back + k));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != -1) return false;
+        }
+        if (std::memcmp(front + k, back + k, common - k) != 0) return false;
+        std::memmove(front, front + common, front_count - common);
+        std::memmove(back, back + common, back_count - common);
+        front_count -= common;
+        back_count -= common;
+    }
+
+    // What's left: the pending front characters, the unread middle and the
+    // pending back characters, which must form a palindrome on their own.
+    std::string rest(front, front_count);
+    for (auto p = lo; p != hi; p++) {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c >= 0x80) return std::nullopt;
+        if (std::isalnum(c)) rest.push_back(static_cast<char>(c | 0x20));
+    }
+    const std::string back_rest(back, back_count);
+    rest.append(back_rest.rbegin(), back_rest.rend());
+    return std::equal(rest.begin(), rest.begin() + rest.size() / 2, rest.rbegin());
+}
+
+// Valid UTF-8 is compared code point by code point, so "Ésope reste ici et se
+// repose" is a palindrome; anything else is compared byte by byte.
+bool is_palindrome_utf8(std::string_view str) {
+    std::u32string folded;
+    for (auto c : Utf8::CodePoints{ str }) {
+        if (Utf8::is_alnum(c)) folded.push_back(Utf8::to_lower(c));
+    }
+    return std::equal(folded.begin(), folded.begin() + folded.size() / 2, folded.rbegin());
+}
+
+bool is_palindrome(std::string_view str) {
+    if (__builtin_cpu_supports("avx2")) {
+        if (auto result = is_palindrome_avx2(str)) return *result;
+    } else if (Utf8::is_ascii(str)) {
+        return is_palindrome_scalar(str);
+    }
+    return Utf8::validate(str) ? is_palindrome_utf8(str) : is_palindrome_scalar(str);
+}
+
 TEST_CASE("is_palindrome") {
   using namespace std::literals::string_literals;
   SECTION("returns true for palindromes") {
@@ -460,21 +1059,65 @@ TEST_CASE("is_palindrome") {
   SECTION("returns false for non-palindromes") {
     REQUIRE_FALSE(is_palindrome("A woman, a plan, a canal, Panama!"s));
   }
+  SECTION("returns true for the empty string") {
+    REQUIRE(is_palindrome(""s));
+  }
+  SECTION("agrees with the scalar version on long sequences") {
+    std::string half;
+    for (size_t i{}; i < 1000; i++) {
+      half += "Ab, 1;c d-"[i % 10];
+      if (i % 7 == 0) half += ' ';
+    }
+    std::string palindrome{ half };
+    palindrome.append(half.rbegin(), half.rend());
+    REQUIRE(is_palindrome(palindrome));
+    for (size_t i : { size_t{ 0 }, size_t{ 100 }, palindrome.size() / 2, palindrome.size() - 1 }) {
+      auto broken{ palindrome };
+      broken[i] = 'x';
+      REQUIRE(is_palindrome(broken) == is_palindrome_scalar(broken));
+    }
+  }
+  SECTION("falls back to the scalar version for non-ASCII input") {
+    std::string accented(100, 'a');
+    accented[10] = '\xe9';
+    accented[89] = '\xe9';
+    REQUIRE(is_palindrome(accented));
+    accented[89] = 'b';
+    REQUIRE_FALSE(is_palindrome(accented));
+  }
+  SECTION("compares UTF-8 code points, ignoring case") {
+    REQUIRE(is_palindrome("\xC3\x89sope reste ici et se repos\xC3\xA9"));   // Ésope ... reposé
+    REQUIRE(is_palindrome("\xD0\x90 \xD1\x80\xD0\xBE\xD0\xB7\xD0\xB0 \xD1\x83\xD0\xBF\xD0\xB0\xD0\xBB\xD0\xB0 "
+                          "\xD0\xBD\xD0\xB0 \xD0\xBB\xD0\xB0\xD0\xBF\xD1\x83 \xD0\x90\xD0\xB7\xD0\xBE\xD1\x80\xD0\xB0"));
+    REQUIRE_FALSE(is_palindrome("\xC3\xA9te"));  // éte
+  }
 }
 
 // Exercise 15-3
 
+// Looking c up in a std::string("aeiouAEIOU") built per call allocates for
+// every character. A CharClass is a table built at compile time, and counts
+// its members 32 bytes at a time (see char_class.h).
+
+#include "char_class.h"
+
 bool is_vowel(char c) {
-  std::string vowels("aeiouAEIOU");
-  return vowels.find(c) != std::string::npos;
+  return CharClasses::vowels.contains(c);
 }
 
+// Non-ASCII text is decoded to count Latin-1's accented vowels as well.
+constexpr std::u32string_view accented_vowels{
+  U"\u00E0\u00E1\u00E2\u00E3\u00E4\u00E5\u00E6\u00E8\u00E9\u00EA\u00EB\u00EC\u00ED\u00EE\u00EF"
+  U"\u00F2\u00F3\u00F4\u00F5\u00F6\u00F8\u00F9\u00FA\u00FB\u00FC" };
+
 int vowel_count(std::string_view str) {
-  int count{};
-  for (auto c : str) {
-    if (is_vowel(c)) count++;
+  const auto count = CharClasses::vowels.count(str);
+  if (Utf8::is_ascii(str)) return static_cast<int>(count);
+  size_t accented{};
+  for (auto c : Utf8::CodePoints{ str }) {
+    accented += c >= 0x80 && accented_vowels.find(Utf8::to_lower(c)) != std::u32string_view::npos;
   }
-  return count;
+  return static_cast<int>(count + accented);
 }
 
 TEST_CASE("vowel_count") {
@@ -494,6 +1137,36 @@ TEST_CASE("vowel_count") {
     std::string mixed("Normal phrase");
     REQUIRE(vowel_count(mixed) == 4);
   }
+  SECTION("identifies accented vowels in UTF-8") {
+    std::string accented("\xC3\x89l\xC3\xA8ve na\xC3\xAFve");  // Élève naïve
+    REQUIRE(vowel_count(accented) == 6);
+  }
+}
+
+TEST_CASE("CharClass") {
+  SECTION("tests membership with a table") {
+    REQUIRE(CharClasses::vowels.contains('e'));
+    REQUIRE_FALSE(CharClasses::vowels.contains('z'));
+    REQUIRE(CharClasses::alnum.contains('7'));
+    REQUIRE((~CharClasses::digits).contains('x'));
+  }
+  SECTION("counts long texts like the table does") {
+    std::string text;
+    for (int i{}; i < 1000; i++) text += static_cast<char>(i * 37);
+    for (const auto& cls : { CharClasses::vowels, CharClasses::alnum,
+                             CharClasses::space, CharClass{ ",;|\"" } }) {
+      REQUIRE(cls.is_vectorizable());
+      size_t expected{};
+      for (auto c : text) expected += cls.contains(c);
+      REQUIRE(cls.count(text) == expected);
+    }
+  }
+  SECTION("falls back to the table for classes without nibble tables") {
+    // Each of these high nibbles pairs with a different set of low nibbles.
+    const CharClass scattered{ "\x01\x12\x23\x34\x45\x56\x67\x78\x89" };
+    REQUIRE_FALSE(scattered.is_vectorizable());
+    REQUIRE(scattered.count("\x01\x12\x23\x34\x45\x56\x67\x78\x89\x9a") == 9);
+  }
 }
 
 // TODO
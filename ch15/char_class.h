@@ -0,0 +1,170 @@
+// ---------------------------------------------------------------------------------
+// Character classes: sets of bytes, such as vowels, digits or delimiters.
+//
+// Membership is a lookup in a 256-entry table built at compile time. For
+// counting or searching long texts, the class is also compiled to a pair of
+// 16-byte "nibble" tables: a byte c is a member when
+//   low_table[c & 0xF] & high_table[c >> 4]
+// is non-zero. Both lookups are a single pshufb, so AVX2 classifies 32 bytes
+// with two shuffles and an and (the "shufti" technique). This works for any
+// class whose high nibbles need at most 8 distinct sets of low nibbles, which
+// covers the usual ASCII classes; other classes use the table.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <immintrin.h>
+
+class CharClass {
+public:
+  constexpr CharClass() = default;
+
+  constexpr CharClass(std::string_view members) {
+    for (auto c : members) table[static_cast<unsigned char>(c)] = true;
+    build_nibble_tables();
+  }
+
+  static constexpr CharClass range(char first, char last) {
+    CharClass result;
+    for (int c = static_cast<unsigned char>(first); c <= static_cast<unsigned char>(last); c++) {
+      result.table[c] = true;
+    }
+    result.build_nibble_tables();
+    return result;
+  }
+
+  constexpr bool contains(char c) const { return table[static_cast<unsigned char>(c)]; }
+
+  constexpr CharClass operator|(const CharClass& other) const {
+    CharClass result;
+    for (size_t c{}; c < 256; c++) result.table[c] = table[c] || other.table[c];
+    result.build_nibble_tables();
+    return result;
+  }
+
+  constexpr CharClass operator~() const {
+    CharClass result;
+    for (size_t c{}; c < 256; c++) result.table[c] = !table[c];
+    result.build_nibble_tables();
+    return result;
+  }
+
+  // Whether the class fits the nibble tables, and so gets the SIMD paths.
+  constexpr bool is_vectorizable() const { return vectorizable; }
+
+  // Number of bytes of text in the class.
+  size_t count(std::string_view text) const {
+    if (vectorizable && __builtin_cpu_supports("avx2")) return count_avx2(text);
+    size_t result{};
+    for (auto c : text) result += contains(c);
+    return result;
+  }
+
+  // Position of the first byte of text at or after pos in the class, or npos.
+  size_t find(std::string_view text, size_t pos = 0) const {
+    if (vectorizable && __builtin_cpu_supports("avx2")) return find_avx2(text, pos);
+    for (; pos < text.size(); pos++) {
+      if (contains(text[pos])) return pos;
+    }
+    return std::string_view::npos;
+  }
+
+  // Compiled for AVX2 only; call through count() and find().
+  __attribute__((target("avx2")))
+  size_t count_avx2(std::string_view text) const {
+    const auto low = nibble_table(low_table);
+    const auto high = nibble_table(high_table);
+    size_t result{}, i{};
+    for (; i + 32 <= text.size(); i += 32) {
+      const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+      result += __builtin_popcount(members_mask(block, low, high));
+    }
+    for (; i < text.size(); i++) result += contains(text[i]);
+    return result;
+  }
+
+  __attribute__((target("avx2")))
+  size_t find_avx2(std::string_view text, size_t pos) const {
+    const auto low = nibble_table(low_table);
+    const auto high = nibble_table(high_table);
+    for (; pos + 32 <= text.size(); pos += 32) {
+      const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + pos));
+      if (const auto mask = members_mask(block, low, high)) return pos + __builtin_ctz(mask);
+    }
+    for (; pos < text.size(); pos++) {
+      if (contains(text[pos])) return pos;
+    }
+    return std::string_view::npos;
+  }
+
+  // One bit per byte of block, set for the members of the class.
+  __attribute__((target("avx2")))
+  uint32_t members_mask(__m256i block, __m256i low, __m256i high) const {
+    const auto nibble = _mm256_set1_epi8(0x0F);
+    const auto low_bits = _mm256_shuffle_epi8(low, _mm256_and_si256(block, nibble));
+    const auto high_bits = _mm256_shuffle_epi8(
+      high, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+    const auto none = _mm256_cmpeq_epi8(_mm256_and_si256(low_bits, high_bits),
+                                        _mm256_setzero_si256());
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(none));
+  }
+
+  // The tables to pass to members_mask, for kernels of other classes.
+  const std::array<uint8_t, 16>& low_nibbles() const { return low_table; }
+  const std::array<uint8_t, 16>& high_nibbles() const { return high_table; }
+
+  // The 16-byte table broadcast to both lanes, as pshufb works per lane.
+  __attribute__((target("avx2")))
+  static __m256i nibble_table(const std::array<uint8_t, 16>& table) {
+    return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data())));
+  }
+
+private:
+  // Groups the high nibbles by the set of low nibbles they pair with; each
+  // distinct set gets one of the 8 bits.
+  constexpr void build_nibble_tables() {
+    uint16_t sets[8]{};
+    int set_count{};
+    for (auto& entry : low_table) entry = 0;
+    for (auto& entry : high_table) entry = 0;
+    vectorizable = true;
+    for (int high = 0; high < 16; high++) {
+      uint16_t lows{};
+      for (int low = 0; low < 16; low++) {
+        if (table[high << 4 | low]) lows |= 1u << low;
+      }
+      if (!lows) continue;
+      int bit{};
+      while (bit < set_count && sets[bit] != lows) bit++;
+      if (bit == set_count) {
+        if (set_count == 8) {
+          vectorizable = false;
+          return;
+        }
+        sets[set_count++] = lows;
+      }
+      high_table[high] |= 1u << bit;
+      for (int low = 0; low < 16; low++) {
+        if (lows & (1u << low)) low_table[low] |= 1u << bit;
+      }
+    }
+  }
+
+  std::array<bool, 256> table{};
+  std::array<uint8_t, 16> low_table{}, high_table{};
+  bool vectorizable{ true };
+};
+
+namespace CharClasses {
+  constexpr CharClass vowels{ "aeiouAEIOU" };
+  constexpr CharClass digits = CharClass::range('0', '9');
+  constexpr CharClass upper = CharClass::range('A', 'Z');
+  constexpr CharClass lower = CharClass::range('a', 'z');
+  constexpr CharClass alpha = upper | lower;
+  constexpr CharClass alnum = alpha | digits;
+  constexpr CharClass space{ " \t\n\v\f\r" };
+}
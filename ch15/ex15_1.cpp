@@ -1,24 +1,8 @@
 #include <string>
 #include <string_view>
-#include <map>
-#include <cctype>
 
-struct AlphaHistogram {
-  void ingest(std::string_view str) {
-    for (auto c : str) {
-      if (std::isalpha(c)) counts[std::toupper(c)]++;
-    }
-  }
-  void print() const {
-    for (auto [c, n] : counts) {
-      printf("%c: ", c);
-      while (n--) printf("*");
-      printf("\n");
-    }
-  }
-private:
-  std::map<char, size_t> counts;
-};
+// The histogram is shared with ch16's Exercise 16-4.
+#include "../ch16/alpha_histogram.h"
 
 int main(int argc, char** argv) {
   AlphaHistogram hist;
@@ -0,0 +1,320 @@
+// ---------------------------------------------------------------------------------
+// Fast number parsing.
+//
+// std::stoi and friends construct from a std::string, consult the locale and
+// throw on errors; operator>> adds stream sentries on top. std::from_chars is
+// the locale-free, non-throwing primitive. The functions here have its
+// interface and are faster for base 10:
+// * integers consume 8 digits at a time with SWAR ("SIMD within a register")
+//   arithmetic on a 64-bit word;
+// * doubles use the Clinger fast path when the decimal is exactly
+//   representable, and otherwise the Eisel-Lemire algorithm: one or two
+//   64x64-bit multiplications by a tabulated power of five.
+// Anything else (hex, inf/nan, more than 19 significant digits, subnormals,
+// overflow) falls back to std::from_chars, so the results are always identical
+// to it.
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "power_of_five_table.h"
+
+namespace NumberParsing {
+
+namespace detail {
+
+inline uint64_t load8(const char* p) {
+  uint64_t word;
+  std::memcpy(&word, p, 8);
+  return word;
+}
+
+// True when all 8 bytes are in '0'..'9'. Assumes little endian, as below.
+inline bool is_eight_digits(uint64_t word) {
+  return ((word & 0xF0F0F0F0F0F0F0F0) |
+          (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+// Combines 8 ASCII digits pairwise: 8 digits -> 4 two-digit values -> 2
+// four-digit values -> 1 eight-digit value, with three multiplications.
+inline uint32_t parse_eight_digits(uint64_t word) {
+  word = ((word & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+  word = ((word & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+  return static_cast<uint32_t>(((word & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+}
+
+inline bool is_digit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+// Accumulates a run of digits into value, returning false on overflow.
+inline bool accumulate_digits(const char*& p, const char* last, uint64_t& value) {
+  while (last - p >= 8 && is_eight_digits(load8(p))) {
+    if (__builtin_mul_overflow(value, 100'000'000, &value) ||
+        __builtin_add_overflow(value, parse_eight_digits(load8(p)), &value)) {
+      return false;
+    }
+    p += 8;
+  }
+  for (; p != last && is_digit(*p); p++) {
+    if (__builtin_mul_overflow(value, 10, &value) ||
+        __builtin_add_overflow(value, static_cast<uint64_t>(*p - '0'), &value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Like accumulate_digits, for digits known to fit; counts them too.
+inline void accumulate_digits(const char*& p, const char* last, uint64_t& value,
+                              int& count) {
+  const auto start = p;
+  while (last - p >= 8 && is_eight_digits(load8(p))) {
+    value = value * 100'000'000 + parse_eight_digits(load8(p));
+    p += 8;
+  }
+  for (; p != last && is_digit(*p); p++) value = value * 10 + (*p - '0');
+  count += static_cast<int>(p - start);
+}
+
+struct Decimal {
+  uint64_t mantissa;
+  int64_t exponent;  // The value is mantissa * 10^exponent.
+  bool negative;
+  const char* end;
+};
+
+// Parses [-]digits[.digits][(e|E)[+|-]digits]. Returns false when the text
+// isn't such a number or has more than 19 significant digits.
+inline bool parse_decimal(const char* p, const char* last, Decimal& decimal) {
+  decimal.negative = p != last && *p == '-';
+  if (decimal.negative) p++;
+
+  const auto digits_start = p;
+  while (p != last && *p == '0') p++;
+  const bool had_leading_zeros = p != digits_start;
+  uint64_t mantissa{};
+  int digits{};
+  accumulate_digits(p, last, mantissa, digits);
+  int64_t exponent{};
+  bool has_digits = had_leading_zeros || digits > 0;
+
+  if (p != last && *p == '.') {
+    p++;
+    const auto fraction_start = p;
+    if (digits == 0) {
+      // Zeros right after the point don't count as significant digits.
+      while (p != last && *p == '0') p++;
+    }
+    accumulate_digits(p, last, mantissa, digits);
+    exponent = -static_cast<int64_t>(p - fraction_start);
+    has_digits = has_digits || p != fraction_start;
+  }
+  if (!has_digits || digits > 19) return false;
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    auto q = p + 1;
+    const bool negative_exponent = q != last && *q == '-';
+    if (q != last && (*q == '-' || *q == '+')) q++;
+    if (q != last && is_digit(*q)) {
+      int64_t explicit_exponent{};
+      for (; q != last && is_digit(*q); q++) {
+        if (explicit_exponent < 100'000) explicit_exponent = explicit_exponent * 10 + (*q - '0');
+      }
+      exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+      p = q;
+    }
+  }
+  decimal.mantissa = mantissa;
+  decimal.exponent = exponent;
+  decimal.end = p;
+  return true;
+}
+
+inline double make_double(bool negative, uint64_t mantissa, int power2) {
+  const uint64_t bits = mantissa | (static_cast<uint64_t>(power2) << 52) |
+                        (static_cast<uint64_t>(negative) << 63);
+  double result;
+  std::memcpy(&result, &bits, sizeof result);
+  return result;
+}
+
+// Clinger's fast path: both the mantissa and the power of ten are exact
+// doubles, so one correctly rounded IEEE operation gives the exact answer.
+inline bool clinger(const Decimal& decimal, double& value) {
+  static constexpr double powers_of_ten[]{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  if (decimal.exponent < -22 || decimal.exponent > 22 ||
+      decimal.mantissa > (uint64_t{ 1 } << 53)) {
+    return false;
+  }
+  value = static_cast<double>(decimal.mantissa);
+  if (decimal.exponent < 0) {
+    value /= powers_of_ten[-decimal.exponent];
+  } else {
+    value *= powers_of_ten[decimal.exponent];
+  }
+  if (decimal.negative) value = -value;
+  return true;
+}
+
+// Eisel-Lemire: multiplies the normalized mantissa by a 128-bit truncation of
+// 5^q and reads the 53-bit result off the top of the product. Returns false
+// for results the fast path doesn't handle (zero, subnormal or overflow).
+inline bool eisel_lemire(const Decimal& decimal, double& value) {
+  const auto q = decimal.exponent;
+  auto w = decimal.mantissa;
+  if (w == 0 || q < smallest_power_of_five || q > largest_power_of_five) return false;
+
+  const int leading_zeros = __builtin_clzll(w);
+  w <<= leading_zeros;
+  const auto& power = power_of_five_128[q - smallest_power_of_five];
+  auto product = static_cast<unsigned __int128>(w) * power[0];
+  uint64_t high = product >> 64, low = static_cast<uint64_t>(product);
+  // When the bits below the 55 we keep are all ones, the truncated part of
+  // 5^q could carry into them, so it's multiplied in as well.
+  if ((high & 0x1FF) == 0x1FF) {
+    const auto second = static_cast<unsigned __int128>(w) * power[1];
+    const uint64_t second_high = second >> 64;
+    low += second_high;
+    if (second_high > low) high++;
+  }
+
+  const int upper_bit = static_cast<int>(high >> 63);
+  const int shift = upper_bit + 64 - 52 - 3;
+  uint64_t mantissa = high >> shift;
+  // floor(log2(10^q)) + 63, the exponent of the product, biased by 1023.
+  int power2 = static_cast<int>((((152170 + 65536) * q) >> 16) + 63 + upper_bit -
+                                leading_zeros + 1023);
+  if (power2 <= 0) return false;
+
+  // An exact tie between two doubles is only possible for small q: round it
+  // to even instead of up.
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+      (mantissa << shift) == high) {
+    mantissa &= ~uint64_t{ 1 };
+  }
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if (mantissa >= (uint64_t{ 2 } << 52)) {
+    mantissa = uint64_t{ 1 } << 52;
+    power2++;
+  }
+  mantissa &= ~(uint64_t{ 1 } << 52);
+  if (power2 >= 0x7FF) return false;
+  value = make_double(decimal.negative, mantissa, power2);
+  return true;
+}
+
+}
+
+// std::from_chars for base-10 integers.
+template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+std::from_chars_result from_chars(const char* first, const char* last, T& value,
+                                  int base = 10) {
+  if (base != 10) return std::from_chars(first, last, value, base);
+  auto p = first;
+  const bool negative = std::is_signed_v<T> && p != last && *p == '-';
+  if (negative) p++;
+  const auto digits_start = p;
+  uint64_t magnitude{};
+  const bool fits = detail::accumulate_digits(p, last, magnitude);
+  if (p == digits_start) return { first, std::errc::invalid_argument };
+  // On overflow the rest of the digits are still consumed, as std does.
+  while (p != last && detail::is_digit(*p)) p++;
+
+  using Unsigned = std::make_unsigned_t<T>;
+  const uint64_t limit = negative
+    ? static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1
+    : static_cast<uint64_t>(std::numeric_limits<T>::max());
+  if (!fits || magnitude > limit) return { p, std::errc::result_out_of_range };
+  value = negative ? static_cast<T>(Unsigned(0) - static_cast<Unsigned>(magnitude))
+                   : static_cast<T>(magnitude);
+  return { p, std::errc{} };
+}
+
+// std::from_chars for doubles in the general (decimal or scientific) format.
+inline std::from_chars_result from_chars(const char* first, const char* last,
+                                         double& value) {
+  detail::Decimal decimal;
+  if (detail::parse_decimal(first, last, decimal)) {
+    if (decimal.mantissa == 0) {
+      value = decimal.negative ? -0.0 : 0.0;
+      return { decimal.end, std::errc{} };
+    }
+    if (detail::clinger(decimal, value) || detail::eisel_lemire(decimal, value)) {
+      return { decimal.end, std::errc{} };
+    }
+  }
+  return std::from_chars(first, last, value);
+}
+
+// std::to_chars is already locale-free and, for doubles, shortest round-trip;
+// these wrap it for convenience.
+template <typename T>
+std::string to_string(T value) {
+  char buffer[32];
+  const auto [end, error] = std::to_chars(buffer, buffer + sizeof buffer, value);
+  return std::string(buffer, end);
+}
+
+// Like std::stoi/std::stod on a string_view: the whole text must be a number.
+template <typename T>
+T parse(std::string_view text) {
+  T value{};
+  const auto [end, error] = NumberParsing::from_chars(text.data(), text.data() + text.size(), value);
+  if (error == std::errc::result_out_of_range) {
+    throw std::out_of_range{ "Number out of range: " + std::string{ text } };
+  }
+  if (error != std::errc{} || end != text.data() + text.size()) {
+    throw std::invalid_argument{ "Not a number: " + std::string{ text } };
+  }
+  return value;
+}
+
+// Parses one number per line of buffer into a vector. Blank lines, '\r' and
+// spaces around the numbers are skipped.
+template <typename T>
+std::vector<T> parse_lines(std::string_view buffer) {
+  std::vector<T> result;
+  result.reserve(buffer.size() / 8);
+  auto p = buffer.data();
+  const auto last = p + buffer.size();
+  size_t line{ 1 };
+  while (p != last) {
+    while (p != last && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p == last) break;
+    if (*p == '\n') {
+      p++;
+      line++;
+      continue;
+    }
+    T value{};
+    const auto [end, error] = NumberParsing::from_chars(p, last, value);
+    if (error == std::errc::result_out_of_range) {
+      throw std::out_of_range{ "Number out of range on line " + std::to_string(line) };
+    }
+    if (error != std::errc{}) {
+      throw std::invalid_argument{ "Not a number on line " + std::to_string(line) };
+    }
+    result.push_back(value);
+    p = end;
+    while (p != last && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p != last && *p != '\n') {
+      throw std::invalid_argument{ "Trailing characters on line " + std::to_string(line) };
+    }
+  }
+  return result;
+}
+
+}
@@ -0,0 +1,338 @@
+// ---------------------------------------------------------------------------------
+// Rope: a string stored as a balanced tree of chunks.
+//
+// std::string's insert, erase, replace and substr copy everything after the
+// edit point, which is O(n) on a multi-megabyte buffer. A rope keeps the text
+// in chunks of at most chunk_size bytes hanging off a balanced tree, so an
+// edit only rebuilds the O(log n) nodes on the path to it.
+//
+// The tree is a treap (a binary search tree by position, a heap by a random
+// priority), which stays balanced in expectation. Nodes are immutable and
+// shared, so copying a rope or taking a substr is O(log n) as well: both
+// ropes point into the same chunks.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Rope {
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+  using ChunkPtr = std::shared_ptr<const std::string>;
+
+  struct Node {
+    Node(ChunkPtr chunk, NodePtr left, NodePtr right, unsigned priority)
+      : chunk{ std::move(chunk) }, left{ std::move(left) },
+        right{ std::move(right) }, priority{ priority },
+        size{ this->chunk->size() + size_of(this->left) + size_of(this->right) } {}
+
+    // Chunks are shared too, so copying a node on an edit path doesn't copy text.
+    const ChunkPtr chunk;
+    const NodePtr left, right;
+    const unsigned priority;
+    const size_t size;
+  };
+
+public:
+  static constexpr size_t chunk_size = 4096;
+  static constexpr size_t npos = std::string_view::npos;
+
+  Rope() = default;
+  Rope(std::string_view text) : root{ build(text) } {}
+
+  size_t size() const { return size_of(root); }
+  bool empty() const { return size() == 0; }
+
+  char operator[](size_t pos) const {
+    const Node* node = root.get();
+    while (node) {
+      const auto left_size = size_of(node->left);
+      if (pos < left_size) {
+        node = node->left.get();
+      } else if (pos < left_size + node->chunk->size()) {
+        return (*node->chunk)[pos - left_size];
+      } else {
+        pos -= left_size + node->chunk->size();
+        node = node->right.get();
+      }
+    }
+    throw std::out_of_range{ "Rope index out of range" };
+  }
+
+  void insert(size_t pos, std::string_view text) {
+    check_position(pos);
+    if (text.empty()) return;
+    // Small insertions go into the chunk they land on, when it has room, so
+    // that many small edits don't shred the rope into tiny chunks.
+    if (text.size() < chunk_size / 2) {
+      if (auto edited = insert_in_chunk(root, pos, text)) {
+        root = std::move(edited);
+        return;
+      }
+    }
+    auto [before, after] = split(root, pos);
+    root = join(join(before, build(text)), after);
+  }
+
+  void append(std::string_view text) { insert(size(), text); }
+
+  void erase(size_t pos, size_t count = npos) {
+    check_position(pos);
+    count = std::min(count, size() - pos);
+    auto [before, rest] = split(root, pos);
+    auto [erased, after] = split(rest, count);
+    root = join(before, after);
+  }
+
+  void replace(size_t pos, size_t count, std::string_view text) {
+    erase(pos, count);
+    insert(pos, text);
+  }
+
+  Rope substr(size_t pos, size_t count = npos) const {
+    check_position(pos);
+    count = std::min(count, size() - pos);
+    auto [before, rest] = split(root, pos);
+    Rope result;
+    result.root = split(rest, count).first;
+    return result;
+  }
+
+  std::string to_string() const {
+    std::string result;
+    result.reserve(size());
+    for (auto chunk : chunks()) result.append(chunk);
+    return result;
+  }
+
+  // Iterates the chunks in order, each as a contiguous std::string_view, so
+  // searches can run memchr/SIMD kernels over whole chunks.
+  class ChunkIterator {
+  public:
+    ChunkIterator() = default;
+    explicit ChunkIterator(const Node* root) { push_left(root); }
+
+    std::string_view operator*() const { return *stack.back()->chunk; }
+
+    ChunkIterator& operator++() {
+      const Node* node = stack.back();
+      stack.pop_back();
+      push_left(node->right.get());
+      return *this;
+    }
+
+    bool operator==(const ChunkIterator& other) const { return stack == other.stack; }
+    bool operator!=(const ChunkIterator& other) const { return !(*this == other); }
+
+  private:
+    void push_left(const Node* node) {
+      for (; node; node = node->left.get()) stack.push_back(node);
+    }
+
+    std::vector<const Node*> stack;
+  };
+
+  struct Chunks {
+    ChunkIterator begin() const { return ChunkIterator{ root }; }
+    ChunkIterator end() const { return ChunkIterator{}; }
+    const Node* root;
+  };
+
+  Chunks chunks() const { return Chunks{ root.get() }; }
+
+  // Searches chunk by chunk; matches straddling a chunk boundary are found in
+  // a small window made of the previous chunk's tail and the next chunk's head.
+  size_t find(std::string_view needle, size_t pos = 0) const {
+    if (pos > size()) return npos;
+    if (pos > 0) {
+      const auto found = substr(pos).find(needle);
+      return found == npos ? npos : pos + found;
+    }
+    if (needle.empty()) return 0;
+
+    const size_t overlap = needle.size() - 1;
+    std::string tail;  // Last `overlap` bytes seen so far.
+    size_t offset{};   // Position of the current chunk in the rope.
+    for (auto chunk : chunks()) {
+      if (!tail.empty()) {
+        std::string window{ tail };
+        window.append(chunk.substr(0, overlap));
+        const auto found = window.find(needle);
+        if (found != std::string::npos && found < tail.size()) {
+          return offset - tail.size() + found;
+        }
+      }
+      const auto found = chunk.find(needle);
+      if (found != std::string_view::npos) return offset + found;
+
+      tail.append(chunk);
+      if (tail.size() > overlap) tail.erase(0, tail.size() - overlap);
+      offset += chunk.size();
+    }
+    return npos;
+  }
+
+  friend bool operator==(const Rope& rope, std::string_view text) {
+    if (rope.size() != text.size()) return false;
+    for (auto chunk : rope.chunks()) {
+      if (text.substr(0, chunk.size()) != chunk) return false;
+      text.remove_prefix(chunk.size());
+    }
+    return true;
+  }
+
+private:
+  static size_t size_of(const NodePtr& node) { return node ? node->size : 0; }
+
+  static unsigned random_priority() {
+    thread_local std::minstd_rand engine{ std::random_device{}() };
+    return engine();
+  }
+
+  static NodePtr make(ChunkPtr chunk, NodePtr left, NodePtr right, unsigned priority) {
+    return std::make_shared<const Node>(std::move(chunk), std::move(left),
+                                        std::move(right), priority);
+  }
+
+  static NodePtr leaf(std::string_view chunk) {
+    if (chunk.empty()) return nullptr;
+    return make(std::make_shared<const std::string>(chunk), nullptr, nullptr,
+                random_priority());
+  }
+
+  void check_position(size_t pos) const {
+    if (pos > size()) throw std::out_of_range{ "Rope position out of range" };
+  }
+
+  // Builds a treap from text in O(n) by inserting chunks left to right
+  // (a Cartesian tree): the right spine is kept on a stack.
+  static NodePtr build(std::string_view text) {
+    struct Draft {
+      ChunkPtr chunk;
+      unsigned priority;
+      int left = -1, right = -1;
+    };
+    std::vector<Draft> drafts;
+    std::vector<int> spine;
+    for (size_t pos{}; pos < text.size(); pos += chunk_size) {
+      drafts.push_back({ std::make_shared<const std::string>(text.substr(pos, chunk_size)),
+                         random_priority() });
+      const int current = static_cast<int>(drafts.size()) - 1;
+      int last_popped = -1;
+      while (!spine.empty() && drafts[spine.back()].priority < drafts[current].priority) {
+        last_popped = spine.back();
+        spine.pop_back();
+      }
+      drafts[current].left = last_popped;
+      if (!spine.empty()) drafts[spine.back()].right = current;
+      spine.push_back(current);
+    }
+    if (spine.empty()) return nullptr;
+
+    struct Freeze {
+      std::vector<Draft>& drafts;
+      NodePtr operator()(int i) const {
+        if (i < 0) return nullptr;
+        auto left = (*this)(drafts[i].left);
+        auto right = (*this)(drafts[i].right);
+        return make(std::move(drafts[i].chunk), std::move(left), std::move(right),
+                    drafts[i].priority);
+      }
+    };
+    return Freeze{ drafts }(spine.front());
+  }
+
+  static NodePtr merge(const NodePtr& left, const NodePtr& right) {
+    if (!left) return right;
+    if (!right) return left;
+    if (left->priority > right->priority) {
+      return make(left->chunk, left->left, merge(left->right, right), left->priority);
+    }
+    return make(right->chunk, merge(left, right->left), right->right, right->priority);
+  }
+
+  static const std::string& first_chunk(const Node* node) {
+    while (node->left) node = node->left.get();
+    return *node->chunk;
+  }
+
+  static const std::string& last_chunk(const Node* node) {
+    while (node->right) node = node->right.get();
+    return *node->chunk;
+  }
+
+  // Concatenates two ropes like merge, but makes one chunk of two neighbours
+  // under half a chunk each, so the fragments that split leaves on every edit
+  // don't pile up: at the seam, and on either side of it, where an earlier
+  // edit may have left a fragment next to the one just cut.
+  static NodePtr join(NodePtr left, NodePtr right) {
+    if (left) {
+      auto [head, last] = split(left, left->size - last_chunk(left.get()).size());
+      left = mend(head, last);
+    }
+    if (right) {
+      auto [first, tail] = split(right, first_chunk(right.get()).size());
+      right = mend(first, tail);
+    }
+    return mend(left, right);
+  }
+
+  static NodePtr mend(const NodePtr& left, const NodePtr& right) {
+    if (!left || !right) return merge(left, right);
+    const auto& last = last_chunk(left.get());
+    const auto& first = first_chunk(right.get());
+    if (last.size() >= chunk_size / 2 || first.size() >= chunk_size / 2) return merge(left, right);
+    const auto head = split(left, left->size - last.size()).first;
+    const auto tail = split(right, first.size()).second;
+    return merge(merge(head, leaf(last + first)), tail);
+  }
+
+  // Splits into the first pos bytes and the rest, cutting a chunk if needed.
+  static std::pair<NodePtr, NodePtr> split(const NodePtr& node, size_t pos) {
+    if (!node) return { nullptr, nullptr };
+    const auto left_size = size_of(node->left);
+    const auto chunk_end = left_size + node->chunk->size();
+    if (pos <= left_size) {
+      auto [a, b] = split(node->left, pos);
+      return { a, make(node->chunk, b, node->right, node->priority) };
+    }
+    if (pos >= chunk_end) {
+      auto [a, b] = split(node->right, pos - chunk_end);
+      return { make(node->chunk, node->left, a, node->priority), b };
+    }
+    const std::string_view chunk{ *node->chunk };
+    const auto cut = pos - left_size;
+    return { merge(node->left, leaf(chunk.substr(0, cut))),
+             merge(leaf(chunk.substr(cut)), node->right) };
+  }
+
+  // Rewrites the chunk containing pos with text spliced in, copying only the
+  // path from the root. Returns nullptr when that chunk would overflow.
+  static NodePtr insert_in_chunk(const NodePtr& node, size_t pos, std::string_view text) {
+    if (!node) return nullptr;
+    const auto left_size = size_of(node->left);
+    const auto chunk_end = left_size + node->chunk->size();
+    if (pos < left_size) {
+      auto left = insert_in_chunk(node->left, pos, text);
+      return left ? make(node->chunk, std::move(left), node->right, node->priority) : nullptr;
+    }
+    if (pos > chunk_end) {
+      auto right = insert_in_chunk(node->right, pos - chunk_end, text);
+      return right ? make(node->chunk, node->left, std::move(right), node->priority) : nullptr;
+    }
+    if (node->chunk->size() + text.size() > chunk_size) return nullptr;
+    auto chunk = std::make_shared<std::string>(*node->chunk);
+    chunk->insert(pos - left_size, text);
+    return make(std::move(chunk), node->left, node->right, node->priority);
+  }
+
+  NodePtr root;
+};
@@ -0,0 +1,52 @@
+// Random edits on a 100 MB buffer: std::string against Rope.
+// Build with `make rope_bench` (optimized, see Makefile).
+
+#include "rope.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+template <typename Fn>
+double us_per_edit(size_t edits, Fn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i{}; i < edits; i++) fn();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(stop - start).count() / edits;
+}
+
+template <typename Text>
+double random_edits(Text& text, size_t edits) {
+  std::mt19937_64 engine{ 42 };
+  return us_per_edit(edits, [&] {
+    const auto pos = engine() % text.size();
+    switch (engine() % 3) {
+      case 0: text.insert(pos, "inserted text "); break;
+      case 1: text.erase(pos, 10); break;
+      default: text.replace(pos, 5, "swap!"); break;
+    }
+  });
+}
+
+int main() {
+  const size_t size = 100'000'000;
+  std::string text(size, ' ');
+  std::mt19937 engine{ 7 };
+  for (auto& c : text) c = 'a' + engine() % 26;
+
+  const auto rope_build_start = std::chrono::steady_clock::now();
+  Rope rope{ text };
+  const auto rope_build_stop = std::chrono::steady_clock::now();
+  printf("Rope build: %.1f ms\n",
+         std::chrono::duration<double, std::milli>(rope_build_stop - rope_build_start).count());
+
+  printf("std::string: %10.2f us/edit\n", random_edits(text, 200));
+  printf("Rope:        %10.2f us/edit\n", random_edits(rope, 200'000));
+
+  const auto needle = text.substr(size / 2, 16);
+  const auto find_start = std::chrono::steady_clock::now();
+  const auto found = rope.find(needle);
+  const auto find_stop = std::chrono::steady_clock::now();
+  printf("Rope find over %zu bytes: %.1f ms (found at %zu)\n", rope.size(),
+         std::chrono::duration<double, std::milli>(find_stop - find_start).count(), found);
+}
@@ -0,0 +1,224 @@
+// ---------------------------------------------------------------------------------
+// String arena and interned string pool.
+//
+// Word-level processing that keeps a std::string per token pays for one heap
+// allocation per token (past the SSO limit) and for comparing whole strings.
+// StringArena copies strings back to back into large blocks, so storing a token
+// is a bump of a pointer. StringPool stores each distinct string once in an
+// arena and names it by a 32-bit id: equal strings get equal ids, so equality
+// is an integer comparison, and the text is still a string_view away.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class StringArena {
+public:
+  static constexpr size_t default_block_size = 64 * 1024;
+
+  explicit StringArena(size_t block_size = default_block_size)
+    : block_size{ block_size } {}
+
+  StringArena(const StringArena&) = delete;
+  StringArena& operator=(const StringArena&) = delete;
+  // The blocks change hands, and the moved-from arena is left empty, so that
+  // storing into it again starts a block of its own.
+  StringArena(StringArena&& other) noexcept
+    : blocks{ std::move(other.blocks) }, current{ std::exchange(other.current, nullptr) },
+      used{ std::exchange(other.used, 0) }, capacity{ std::exchange(other.capacity, 0) },
+      reserved{ std::exchange(other.reserved, 0) }, block_size{ other.block_size } {
+    other.blocks.clear();
+  }
+
+  StringArena& operator=(StringArena&& other) noexcept {
+    if (this == &other) return *this;
+    blocks = std::move(other.blocks);
+    other.blocks.clear();
+    current = std::exchange(other.current, nullptr);
+    used = std::exchange(other.used, 0);
+    capacity = std::exchange(other.capacity, 0);
+    reserved = std::exchange(other.reserved, 0);
+    block_size = other.block_size;
+    return *this;
+  }
+
+  // Copies text into the arena. The view stays valid as long as the arena.
+  std::string_view store(std::string_view text) {
+    auto destination = allocate(text.size());
+    if (!text.empty()) std::memcpy(destination, text.data(), text.size());
+    return { destination, text.size() };
+  }
+
+  size_t bytes_reserved() const { return reserved; }
+
+  // Builds a string in place at the end of the arena, so appending never
+  // allocates per string. Nothing else may be stored in the arena until the
+  // builder is finished or discarded.
+  class Builder {
+  public:
+    explicit Builder(StringArena& arena)
+      : arena{ arena }, start{ arena.current + arena.used } {}
+
+    Builder& append(std::string_view text) {
+      auto destination = reserve(text.size());
+      if (!text.empty()) std::memcpy(destination, text.data(), text.size());
+      return *this;
+    }
+
+    Builder& push_back(char c) {
+      *reserve(1) = c;
+      return *this;
+    }
+
+    std::string_view view() const { return { start, length }; }
+    size_t size() const { return length; }
+
+    std::string_view finish() {
+      const auto result = view();
+      start = nullptr;
+      length = 0;
+      return result;
+    }
+
+    // Gives the bytes back; only valid while nothing was stored after them.
+    void discard() {
+      arena.used -= length;
+      arena.reserved -= length;
+      start = nullptr;
+      length = 0;
+    }
+
+  private:
+    char* reserve(size_t n) {
+      if (arena.capacity - arena.used < n) {
+        // Moves the partial string to a block with room for it to double.
+        const char* old_start = start;
+        arena.new_block(std::max(arena.block_size, 2 * (length + n)));
+        start = arena.allocate(length);
+        if (length) std::memcpy(start, old_start, length);
+      } else if (!start) {
+        start = arena.current + arena.used;
+      }
+      auto destination = arena.allocate(n);
+      length += n;
+      return destination;
+    }
+
+    StringArena& arena;
+    char* start;
+    size_t length{};
+  };
+
+  Builder builder() { return Builder{ *this }; }
+
+private:
+  char* allocate(size_t n) {
+    if (capacity - used < n) new_block(std::max(block_size, n));
+    auto result = current + used;
+    used += n;
+    reserved += n;
+    return result;
+  }
+
+  void new_block(size_t size) {
+    blocks.emplace_back(new char[size]);
+    current = blocks.back().get();
+    used = 0;
+    capacity = size;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char* current{};
+  size_t used{}, capacity{}, reserved{};
+  size_t block_size;
+};
+
+class StringPool {
+public:
+  using Id = uint32_t;
+
+  StringPool() : table(16, empty) {}
+
+  // Returns the id of text, storing it first if it's new.
+  Id intern(std::string_view text) {
+    const auto hash = hash_of(text);
+    const auto slot = find_slot(text, hash);
+    if (table[slot] != empty) return table[slot];
+    return add(arena.store(text), hash, slot);
+  }
+
+  // Interns a string built in this pool's arena without copying it again;
+  // if it was already interned, its bytes are given back to the arena.
+  Id intern(StringArena::Builder& builder) {
+    const auto text = builder.view();
+    const auto hash = hash_of(text);
+    const auto slot = find_slot(text, hash);
+    if (table[slot] != empty) {
+      builder.discard();
+      return table[slot];
+    }
+    return add(builder.finish(), hash, slot);
+  }
+
+  // Returns the id of text, or StringPool::npos if it was never interned.
+  Id find(std::string_view text) const {
+    return table[find_slot(text, hash_of(text))];
+  }
+
+  std::string_view view(Id id) const { return strings[id]; }
+  std::string_view operator[](Id id) const { return strings[id]; }
+  size_t size() const { return strings.size(); }
+
+  StringArena::Builder builder() { return arena.builder(); }
+
+  static constexpr Id npos = UINT32_MAX;
+
+private:
+  static constexpr Id empty = npos;
+
+  // FNV-1a: short and good enough for word-sized keys.
+  static uint64_t hash_of(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+  }
+
+  // Open addressing with linear probing; the table is kept at most half full.
+  size_t find_slot(std::string_view text, uint64_t hash) const {
+    const auto mask = table.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+      const auto id = table[slot];
+      if (id == empty || (hashes[id] == hash && strings[id] == text)) return slot;
+    }
+  }
+
+  Id add(std::string_view stored, uint64_t hash, size_t slot) {
+    const auto id = static_cast<Id>(strings.size());
+    strings.push_back(stored);
+    hashes.push_back(hash);
+    table[slot] = id;
+    if (2 * strings.size() > table.size()) rehash(2 * table.size());
+    return id;
+  }
+
+  void rehash(size_t new_size) {
+    table.assign(new_size, empty);
+    const auto mask = new_size - 1;
+    for (Id id{}; id < strings.size(); id++) {
+      auto slot = hashes[id] & mask;
+      while (table[slot] != empty) slot = (slot + 1) & mask;
+      table[slot] = id;
+    }
+  }
+
+  StringArena arena;
+  std::vector<std::string_view> strings;
+  std::vector<uint64_t> hashes;
+  std::vector<Id> table;
+};
@@ -0,0 +1,272 @@
+// ---------------------------------------------------------------------------------
+// Zero-copy tokenizer.
+//
+// boost::tokenizer copies each token into a std::string. Tokenizer is a lazy
+// range of std::string_views into the input instead, so tokenizing allocates
+// nothing; the input must outlive the tokens. Delimiters are found with
+// memchr for a single delimiter byte and with CharClass's SIMD search for
+// several.
+//
+// By default, like boost::char_separator, runs of delimiters are skipped and
+// no empty tokens are produced. Tokenizer::csv keeps empty fields and reads
+// quoted fields: the token is the text between the quotes, in which a quote is
+// escaped by doubling it (Tokenizer::unescape undoes that, with a copy).
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "char_class.h"
+
+class Tokenizer {
+public:
+  static constexpr size_t npos = std::string_view::npos;
+
+  Tokenizer(std::string_view text, std::string_view delimiters)
+    : text{ text }, delimiters{ delimiters },
+      single_delimiter{ delimiters.size() == 1 ? delimiters[0] : '\0' },
+      is_single_delimiter{ delimiters.size() == 1 } {}
+
+  static Tokenizer csv(std::string_view text, char delimiter = ',', char quote = '"') {
+    Tokenizer result{ text, std::string_view{ &delimiter, 1 } };
+    result.keep_empty = true;
+    result.quote = quote;
+    result.is_quoted = true;
+    return result;
+  }
+
+  static std::string unescape(std::string_view field, char quote = '"') {
+    std::string result;
+    result.reserve(field.size());
+    for (size_t i{}; i < field.size(); i++) {
+      result.push_back(field[i]);
+      if (field[i] == quote && i + 1 < field.size() && field[i + 1] == quote) i++;
+    }
+    return result;
+  }
+
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    Iterator() = default;
+    explicit Iterator(const Tokenizer* tokenizer) : tokenizer{ tokenizer } {
+      if (tokenizer->text.empty()) {
+        this->tokenizer = nullptr;
+      } else {
+        ++*this;
+      }
+    }
+
+    std::string_view operator*() const { return token; }
+    const std::string_view* operator->() const { return &token; }
+
+    Iterator& operator++() {
+      if (!tokenizer->next(position, token)) tokenizer = nullptr;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto copy{ *this };
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return tokenizer == other.tokenizer && (!tokenizer || position == other.position);
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+  private:
+    const Tokenizer* tokenizer{};
+    size_t position{};
+    std::string_view token;
+  };
+
+  Iterator begin() const { return Iterator{ this }; }
+  Iterator end() const { return Iterator{}; }
+
+  // Calls fn with each token, in order. Faster than iterating for short
+  // tokens: delimiters are located 32 bytes at a time as a bitmask, and the
+  // tokens are read off its set bits. Quoted fields use the iterator.
+  template <typename Fn>
+  void for_each(Fn fn) const {
+    if (is_quoted || !(is_single_delimiter || delimiters.is_vectorizable()) ||
+        !__builtin_cpu_supports("avx2")) {
+      for (auto token : *this) fn(token);
+      return;
+    }
+    for_each_avx2(fn);
+  }
+
+  // Tokenizes with several threads and returns all the tokens, in order. The
+  // text is cut into one piece per thread, each cut just after a delimiter
+  // (and, for CSV, outside quotes), so no token straddles two pieces.
+  std::vector<std::string_view> parallel(size_t threads = std::thread::hardware_concurrency()) const {
+    if (text.empty()) return {};
+    threads = std::max<size_t>(1, std::min(threads, text.size() / minimum_piece + 1));
+    const auto cuts = safe_cuts(threads);
+    std::vector<std::vector<std::string_view>> pieces(cuts.size() - 1);
+    std::vector<std::thread> workers;
+    for (size_t i{}; i + 1 < cuts.size(); i++) {
+      workers.emplace_back([&, i] {
+        // All but the last piece end with the delimiter that ends its last
+        // token, which is left out so it doesn't start another (empty) one.
+        // An empty piece is still a token when empty ones are kept, the last
+        // one too: a cut just after the text's final delimiter leaves the
+        // empty field that follows it.
+        const bool last = i + 2 == cuts.size();
+        auto piece = text.substr(cuts[i], cuts[i + 1] - cuts[i] - (last ? 0 : 1));
+        if (piece.empty() && keep_empty) {
+          pieces[i].push_back(piece);
+          return;
+        }
+        auto tokenizer{ *this };
+        tokenizer.text = piece;
+        tokenizer.for_each([&](std::string_view token) { pieces[i].push_back(token); });
+      });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<std::string_view> result;
+    for (auto& piece : pieces) result.insert(result.end(), piece.begin(), piece.end());
+    return result;
+  }
+
+private:
+  static constexpr size_t minimum_piece = 64 * 1024;
+
+  template <typename Fn>
+  __attribute__((target("avx2")))
+  void for_each_avx2(Fn& fn) const {
+    if (text.empty()) return;
+    const auto single = _mm256_set1_epi8(single_delimiter);
+    const auto low = CharClass::nibble_table(delimiters.low_nibbles());
+    const auto high = CharClass::nibble_table(delimiters.high_nibbles());
+    const auto emit = [&](size_t start, size_t stop) {
+      if (keep_empty || stop > start) fn(text.substr(start, stop - start));
+    };
+    size_t token_start{}, i{};
+    for (; i + 32 <= text.size(); i += 32) {
+      const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+      uint32_t mask = is_single_delimiter
+        ? static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, single)))
+        : delimiters.members_mask(block, low, high);
+      while (mask) {
+        const auto delimiter = i + __builtin_ctz(mask);
+        emit(token_start, delimiter);
+        token_start = delimiter + 1;
+        mask &= mask - 1;
+      }
+    }
+    for (; i < text.size(); i++) {
+      if (is_delimiter(text[i])) {
+        emit(token_start, i);
+        token_start = i + 1;
+      }
+    }
+    emit(token_start, text.size());
+  }
+
+  bool is_delimiter(char c) const {
+    return is_single_delimiter ? c == single_delimiter : delimiters.contains(c);
+  }
+
+  size_t find_delimiter(size_t pos) const {
+    if (pos >= text.size()) return npos;
+    if (is_single_delimiter) {
+      auto found = std::memchr(text.data() + pos, single_delimiter, text.size() - pos);
+      return found ? static_cast<const char*>(found) - text.data() : npos;
+    }
+    return delimiters.find(text, pos);
+  }
+
+  // Reads the token starting at position, and moves position past the
+  // delimiter that ends it. position == npos marks the end.
+  bool next(size_t& position, std::string_view& token) const {
+    if (position == npos) return false;
+    if (!keep_empty) {
+      while (position < text.size() && is_delimiter(text[position])) position++;
+      if (position == text.size()) return false;
+    }
+
+    auto start = position, stop = npos;
+    if (is_quoted && position < text.size() && text[position] == quote) {
+      start = position + 1;
+      stop = closing_quote(start);
+      position = stop == npos ? npos : find_delimiter(stop + 1);
+    } else {
+      position = find_delimiter(position);
+      stop = position;
+    }
+    token = text.substr(start, stop == npos ? npos : stop - start);
+    if (position != npos) position++;
+    return true;
+  }
+
+  size_t closing_quote(size_t pos) const {
+    while (true) {
+      auto found = text.find(quote, pos);
+      if (found == npos || found + 1 == text.size() || text[found + 1] != quote) return found;
+      pos = found + 2;
+    }
+  }
+
+  // Piece boundaries: the first is 0, the last text.size(), and the others
+  // just after a delimiter that isn't inside quotes.
+  std::vector<size_t> safe_cuts(size_t pieces) const {
+    std::vector<size_t> targets;
+    for (size_t i{ 1 }; i < pieces; i++) targets.push_back(text.size() * i / pieces);
+
+    // Quote parity at each target: counted per stretch in parallel.
+    std::vector<size_t> quotes(targets.size() + 1);
+    if (is_quoted) {
+      std::vector<std::thread> workers;
+      for (size_t i{}; i <= targets.size(); i++) {
+        workers.emplace_back([&, i] {
+          const auto first = i ? targets[i - 1] : 0;
+          const auto last = i < targets.size() ? targets[i] : text.size();
+          quotes[i] = std::count(text.begin() + first, text.begin() + last, quote);
+        });
+      }
+      for (auto& worker : workers) worker.join();
+    }
+
+    std::vector<size_t> cuts{ 0 };
+    bool inside_quotes{};
+    for (size_t i{}; i < targets.size(); i++) {
+      inside_quotes ^= quotes[i] & 1;
+      // The previous piece already reached past this target.
+      if (cuts.back() > targets[i]) continue;
+      auto pos = targets[i];
+      auto inside = inside_quotes;
+      // Walks to the next delimiter outside quotes.
+      while (pos < text.size() && (inside || !is_delimiter(text[pos]))) {
+        if (is_quoted && text[pos] == quote) inside = !inside;
+        pos++;
+      }
+      if (pos >= text.size()) break;
+      cuts.push_back(pos + 1);
+    }
+    cuts.push_back(text.size());
+    return cuts;
+  }
+
+  std::string_view text;
+  CharClass delimiters;
+  char single_delimiter;
+  bool is_single_delimiter;
+  bool keep_empty{};
+  bool is_quoted{};
+  char quote{ '"' };
+};
@@ -0,0 +1,444 @@
+// ---------------------------------------------------------------------------------
+// UTF-8: validation, decoding and a little classification.
+//
+// std::string holds bytes, and a UTF-8 character (code point) takes one to
+// four of them: 0xxxxxxx for ASCII, otherwise a lead byte 110xxxxx, 1110xxxx
+// or 11110xxx followed by that many continuation bytes 10xxxxxx. Functions
+// that look at one byte at a time misclassify everything past ASCII.
+//
+// validate() is the lookup-table method of Keiser and Lemire ("Validating
+// UTF-8 In Less Than One Instruction Per Byte"): every error shows up in some
+// pair of adjacent bytes, so three 16-entry tables indexed by the previous
+// byte's nibbles and the current byte's high nibble, and'ed together, flag
+// all of them for 32 bytes at a time. The only errors needing more context,
+// continuation bytes missing after a 3- or 4-byte lead, are checked with the
+// bytes two and three back.
+//
+// Everything checks for an all-ASCII block first and skips the rest of the
+// work, so ASCII text only pays for an or and a movemask per 32 bytes.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <immintrin.h>
+
+namespace Utf8 {
+
+constexpr char32_t replacement = 0xFFFD;
+
+namespace detail {
+
+__attribute__((target("avx2")))
+inline bool is_ascii_avx2(std::string_view text) {
+  size_t i{};
+  auto bits = _mm256_setzero_si256();
+  for (; i + 32 <= text.size(); i += 32) {
+    bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i)));
+  }
+  if (_mm256_movemask_epi8(bits)) return false;
+  for (; i < text.size(); i++) {
+    if (static_cast<unsigned char>(text[i]) >= 0x80) return false;
+  }
+  return true;
+}
+
+// Error bits; see the paper for the byte patterns each one covers.
+constexpr uint8_t too_short = 1 << 0;      // Lead or ASCII where a continuation is due.
+constexpr uint8_t too_long = 1 << 1;       // Continuation after ASCII.
+constexpr uint8_t overlong_3 = 1 << 2;     // 11100000 100_____
+constexpr uint8_t too_large = 1 << 3;      // Above U+10FFFF.
+constexpr uint8_t surrogate = 1 << 4;      // 11101101 101_____
+constexpr uint8_t overlong_2 = 1 << 5;     // 1100000_ 10______
+constexpr uint8_t too_large_1000 = 1 << 6;
+constexpr uint8_t overlong_4 = 1 << 6;     // 11110000 1000____
+constexpr uint8_t two_continuations = 1 << 7;
+constexpr uint8_t carry = too_short | too_long | two_continuations;
+
+__attribute__((target("avx2")))
+inline __m256i lookup(__m256i nibbles, const uint8_t (&table)[16]) {
+  return _mm256_shuffle_epi8(
+    _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table))),
+    nibbles);
+}
+
+// The bytes of current shifted right by n, with the last n bytes of before
+// shifted in.
+template <int n>
+__attribute__((target("avx2")))
+inline __m256i previous(__m256i current, __m256i before) {
+  return _mm256_alignr_epi8(current, _mm256_permute2x128_si256(before, current, 0x21), 16 - n);
+}
+
+// Non-zero where the block, preceded by previous_block, is invalid.
+__attribute__((target("avx2")))
+inline __m256i block_errors(__m256i block, __m256i previous_block) {
+  static constexpr uint8_t byte_1_high[16]{
+    // 0_______: ASCII
+    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+    // 10______: continuation
+    two_continuations, two_continuations, two_continuations, two_continuations,
+    // 1100____, 1101____: 2-byte lead
+    too_short | overlong_2, too_short,
+    // 1110____: 3-byte lead
+    too_short | overlong_3 | surrogate,
+    // 1111____: 4-byte lead
+    too_short | too_large | too_large_1000 | overlong_4,
+  };
+  static constexpr uint8_t byte_1_low[16]{
+    carry | overlong_3 | overlong_2 | overlong_4,    // ____0000
+    carry | overlong_2,                             // ____0001
+    carry, carry,                                   // ____001_
+    carry | too_large,                              // ____0100
+    carry | too_large | too_large_1000,             // ____0101
+    carry | too_large | too_large_1000,             // ____011_
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,             // ____1___
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate, // ____1101
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+  };
+  static constexpr uint8_t byte_2_high[16]{
+    // 0_______: ASCII
+    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+    // 1000____
+    too_long | overlong_2 | two_continuations | overlong_3 | too_large_1000 | overlong_4,
+    // 1001____
+    too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+    // 101_____
+    too_long | overlong_2 | two_continuations | surrogate | too_large,
+    too_long | overlong_2 | two_continuations | surrogate | too_large,
+    // 11______: lead
+    too_short, too_short, too_short, too_short,
+  };
+
+  const auto nibble = _mm256_set1_epi8(0x0F);
+  const auto previous_1 = previous<1>(block, previous_block);
+  const auto special_cases = _mm256_and_si256(
+    _mm256_and_si256(
+      lookup(_mm256_and_si256(_mm256_srli_epi16(previous_1, 4), nibble), byte_1_high),
+      lookup(_mm256_and_si256(previous_1, nibble), byte_1_low)),
+    lookup(_mm256_and_si256(_mm256_srli_epi16(block, 4), nibble), byte_2_high));
+
+  // Bytes 2 or 3 after a 3- or 4-byte lead must be continuations: exactly
+  // where two_continuations is set.
+  const auto third = _mm256_subs_epu8(previous<2>(block, previous_block),
+                                      _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+  const auto fourth = _mm256_subs_epu8(previous<3>(block, previous_block),
+                                       _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  const auto must_be_continuation = _mm256_and_si256(
+    _mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+  return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+// Adds the errors of block, which follows previous_block, to errors.
+__attribute__((target("avx2")))
+inline void check_block(__m256i block, __m256i& previous_block, __m256i& incomplete,
+                        __m256i& errors) {
+  // Non-zero when the block ends inside a sequence; then the next block must
+  // not be all ASCII.
+  const auto incomplete_limits = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+  if (!_mm256_movemask_epi8(block)) {
+    errors = _mm256_or_si256(errors, incomplete);
+  } else {
+    errors = _mm256_or_si256(errors, block_errors(block, previous_block));
+    incomplete = _mm256_subs_epu8(block, incomplete_limits);
+  }
+  previous_block = block;
+}
+
+__attribute__((target("avx2")))
+inline bool validate_avx2(std::string_view text) {
+  auto errors = _mm256_setzero_si256();
+  auto previous_block = _mm256_setzero_si256();
+  auto incomplete = _mm256_setzero_si256();
+  size_t i{};
+  for (; i + 32 <= text.size(); i += 32) {
+    check_block(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i)),
+                previous_block, incomplete, errors);
+  }
+  // The rest, padded with zeros: ASCII, so a truncated last sequence is an
+  // error like any other.
+  char last[32]{};
+  if (i < text.size()) std::memcpy(last, text.data() + i, text.size() - i);
+  check_block(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(last)),
+              previous_block, incomplete, errors);
+  return _mm256_testz_si256(errors, errors);
+}
+
+}
+
+// Decodes the code point at p, storing it in code_point and returning its
+// length in bytes. An invalid byte decodes to U+FFFD with length 1, so
+// decoding always makes progress.
+inline size_t decode(const char* p, const char* end, char32_t& code_point) {
+  const auto byte = [&](size_t i) { return static_cast<unsigned char>(p[i]); };
+  const auto lead = byte(0);
+  if (lead < 0x80) {
+    code_point = lead;
+    return 1;
+  }
+  size_t length;
+  char32_t minimum;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2, minimum = 0x80, code_point = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3, minimum = 0x800, code_point = lead & 0x0F;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4, minimum = 0x10000, code_point = lead & 0x07;
+  } else {
+    code_point = replacement;
+    return 1;
+  }
+  if (static_cast<size_t>(end - p) < length) {
+    code_point = replacement;
+    return 1;
+  }
+  for (size_t i{ 1 }; i < length; i++) {
+    if ((byte(i) & 0xC0) != 0x80) {
+      code_point = replacement;
+      return 1;
+    }
+    code_point = code_point << 6 | (byte(i) & 0x3F);
+  }
+  if (code_point < minimum || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    code_point = replacement;
+    return 1;
+  }
+  return length;
+}
+
+inline void encode(char32_t code_point, std::string& out) {
+  if (code_point < 0x80) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | code_point >> 6));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | code_point >> 12));
+    out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | code_point >> 18));
+    out.push_back(static_cast<char>(0x80 | (code_point >> 12 & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+inline std::string encode(char32_t code_point) {
+  std::string result;
+  encode(code_point, result);
+  return result;
+}
+
+inline bool is_ascii(std::string_view text) {
+  if (__builtin_cpu_supports("avx2")) return detail::is_ascii_avx2(text);
+  for (auto c : text) {
+    if (static_cast<unsigned char>(c) >= 0x80) return false;
+  }
+  return true;
+}
+
+// Whether text is well-formed UTF-8: no stray continuation bytes, truncated
+// or overlong sequences, surrogates, or code points past U+10FFFF.
+inline bool validate(std::string_view text) {
+  if (__builtin_cpu_supports("avx2")) return detail::validate_avx2(text);
+  for (size_t i{}; i < text.size();) {
+    char32_t code_point;
+    const auto length = decode(text.data() + i, text.data() + text.size(), code_point);
+    if (code_point == replacement && length == 1) return false;
+    i += length;
+  }
+  return true;
+}
+
+// The code points of a string_view, read with decode().
+class CodePoints {
+public:
+  explicit CodePoints(std::string_view text) : text{ text } {}
+
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = char32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char32_t*;
+    using reference = char32_t;
+
+    Iterator(const char* p, const char* end) : p{ p }, end{ end } { read(); }
+
+    char32_t operator*() const { return code_point; }
+    // Where the current code point starts.
+    const char* position() const { return p; }
+
+    Iterator& operator++() {
+      p += length;
+      read();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto copy{ *this };
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator& other) const { return p == other.p; }
+    bool operator!=(const Iterator& other) const { return p != other.p; }
+
+  private:
+    void read() {
+      if (p == end) return;
+      // ASCII doesn't go through the decoder.
+      if (static_cast<unsigned char>(*p) < 0x80) {
+        code_point = static_cast<unsigned char>(*p);
+        length = 1;
+      } else {
+        length = decode(p, end, code_point);
+      }
+    }
+
+    const char* p;
+    const char* end;
+    char32_t code_point{};
+    size_t length{};
+  };
+
+  Iterator begin() const { return { text.data(), text.data() + text.size() }; }
+  Iterator end() const { return { text.data() + text.size(), text.data() + text.size() }; }
+
+private:
+  std::string_view text;
+};
+
+namespace detail {
+
+__attribute__((target("avx2")))
+inline size_t to_utf32_avx2(std::string_view text, std::u32string& out) {
+  size_t i{};
+  for (; i + 32 <= text.size(); i += 32) {
+    const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+    if (_mm256_movemask_epi8(block)) break;
+    const auto size = out.size();
+    out.resize(size + 32);
+    auto* destination = reinterpret_cast<__m256i*>(out.data() + size);
+    for (int k{}; k < 4; k++) {
+      const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(text.data() + i + 8 * k));
+      _mm256_storeu_si256(destination + k, _mm256_cvtepu8_epi32(bytes));
+    }
+  }
+  return i;
+}
+
+}
+
+// Decodes text into out; invalid bytes become U+FFFD. Runs of ASCII are
+// widened 8 bytes per instruction.
+inline std::u32string to_utf32(std::string_view text) {
+  std::u32string result;
+  result.reserve(text.size());
+  const bool avx2 = __builtin_cpu_supports("avx2");
+  for (size_t i{}; i < text.size();) {
+    if (avx2) {
+      i += detail::to_utf32_avx2(text.substr(i), result);
+      if (i == text.size()) break;
+    }
+    // Up to the next 32-byte ASCII block, one code point at a time.
+    const auto stop = std::min(text.size(), i + 32);
+    while (i < stop) {
+      char32_t code_point;
+      i += decode(text.data() + i, text.data() + text.size(), code_point);
+      result.push_back(code_point);
+    }
+  }
+  return result;
+}
+
+// Number of code points in valid UTF-8 text: the bytes that aren't
+// continuations.
+inline size_t length(std::string_view text) {
+  size_t result{};
+  for (auto c : text) result += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+  return result;
+}
+
+// Occurrences of code_point in valid UTF-8 text. A code point's encoding can
+// only match at a code point boundary, so this is a substring count.
+inline size_t count(std::string_view text, char32_t code_point) {
+  const auto needle = encode(code_point);
+  size_t result{};
+  for (auto pos = text.find(needle); pos != std::string_view::npos;
+       pos = text.find(needle, pos + needle.size())) {
+    result++;
+  }
+  return result;
+}
+
+// Case mapping and classification for ASCII, Latin-1, Latin Extended-A, Greek
+// and Cyrillic; full Unicode needs the Unicode Character Database. Other code
+// points map to themselves and, outside the punctuation and symbol blocks,
+// count as letters.
+constexpr char32_t to_lower(char32_t c) {
+  if (c < 0x80) return c >= 'A' && c <= 'Z' ? c + 0x20 : c;
+  if ((c >= 0xC0 && c <= 0xDE && c != 0xD7) ||  // Latin-1
+      (c >= 0x391 && c <= 0x3AB && c != 0x3A2) ||  // Greek
+      (c >= 0x410 && c <= 0x42F)) {  // Cyrillic
+    return c + 0x20;
+  }
+  if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+  // Turkish dotted capital I lowers to plain i, and dotless i has no
+  // lowercase to pair with.
+  if (c == 0x130) return 'i';
+  if (c == 0x131) return c;
+  // Latin Extended-A pairs capitals with the next code point.
+  if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c | 1;
+  if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return c + (c & 1);
+  return c;
+}
+
+constexpr char32_t to_upper(char32_t c) {
+  if (c < 0x80) return c >= 'a' && c <= 'z' ? c - 0x20 : c;
+  if ((c >= 0xE0 && c <= 0xFE && c != 0xF7) ||
+      (c >= 0x3B1 && c <= 0x3CB && c != 0x3C2) ||
+      (c >= 0x430 && c <= 0x44F)) {
+    return c - 0x20;
+  }
+  if (c >= 0x450 && c <= 0x45F) return c - 0x50;
+  // Dotless i uppercases to plain I, and final sigma to the one capital sigma.
+  if (c == 0x131) return 'I';
+  if (c == 0x3C2) return 0x3A3;
+  if (c == 0x130) return c;
+  if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c & ~char32_t{ 1 };
+  if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return c - !(c & 1);
+  return c;
+}
+
+constexpr bool is_alpha(char32_t c) {
+  if (c < 0x80) return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+  if (c < 0xC0) return c == 0xAA || c == 0xB5 || c == 0xBA;
+  if (c == 0xD7 || c == 0xF7) return false;
+  return !((c >= 0x2000 && c <= 0x2BFF) ||    // Punctuation, symbols, arrows...
+           (c >= 0x3000 && c <= 0x303F) ||    // CJK punctuation
+           (c >= 0xFE30 && c <= 0xFE4F) ||    // CJK compatibility forms
+           (c >= 0xFF00 && c <= 0xFF20) ||    // Fullwidth punctuation
+           (c >= 0x1F000 && c <= 0x1FAFF) ||  // Emoji and pictographs
+           c == replacement);
+}
+
+constexpr bool is_alnum(char32_t c) { return (c >= '0' && c <= '9') || is_alpha(c); }
+
+}
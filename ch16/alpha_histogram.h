@@ -0,0 +1,200 @@
+// ---------------------------------------------------------------------------------
+// AlphaHistogram: letter counts over large texts.
+//
+// Counting into a std::map<char, size_t> walks a tree for every letter. The 26
+// ASCII letters are counted in an array instead, 32 bytes at a time with AVX2:
+// each block is folded to upper case, compared against each letter, and the
+// matches accumulated in byte counters that are summed every 255 blocks,
+// before they can overflow. A block with a byte past ASCII leaves the vector
+// loop, which resumes after it. Letters beyond ASCII are counted by code point
+// (see ../ch15/utf8.h): those with 2-byte encodings (Latin, Greek, Cyrillic,
+// Hebrew, Arabic...) in the array as well, the rest in a map.
+//
+// A histogram is a sum, so large buffers are split between threads that each
+// count into their own histogram, and the histograms are added at the end:
+// the threads share nothing and never wait on each other.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <immintrin.h>
+
+#include "../ch15/utf8.h"
+#include "mapped_file.h"
+
+class AlphaHistogram {
+public:
+  void ingest(std::string_view text) {
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    for (size_t i{}; i < text.size();) {
+      if (avx2) {
+        i += ingest_ascii_avx2(text.substr(i));
+        if (i == text.size()) break;
+      }
+      // Up to the next 32-byte block, one code point at a time. Blocks with
+      // bytes past ASCII end up here too.
+      const auto stop = std::min(text.size(), i + 32);
+      while (i < stop) {
+        char32_t c;
+        i += Utf8::decode(text.data() + i, text.data() + text.size(), c);
+        add(c);
+      }
+    }
+  }
+
+  // Splits text between threads, cutting it at code point boundaries.
+  void ingest(std::string_view text, size_t threads) {
+    threads = std::max<size_t>(1, std::min(threads, text.size() / minimum_piece + 1));
+    std::vector<AlphaHistogram> pieces(threads);
+    std::vector<std::thread> workers;
+    size_t start{};
+    for (size_t t{}; t < threads; t++) {
+      auto stop = t + 1 == threads ? text.size() : text.size() * (t + 1) / threads;
+      while (stop < text.size() && (static_cast<unsigned char>(text[stop]) & 0xC0) == 0x80) stop++;
+      stop = std::max(stop, start);
+      workers.emplace_back([&pieces, t, piece = text.substr(start, stop - start)] {
+        pieces[t].ingest(piece);
+      });
+      start = stop;
+    }
+    for (auto& worker : workers) worker.join();
+    for (const auto& piece : pieces) *this += piece;
+  }
+
+  // Streams the file through memory-mapped windows, each counted in parallel.
+  void ingest_file(const std::string& path,
+                   size_t threads = std::thread::hardware_concurrency()) {
+    MappedFile file{ path };
+    file.for_each_window([&](std::string_view window, bool is_last) {
+      // A code point cut by the end of the window is left for the next one.
+      auto end = window.size();
+      if (!is_last) {
+        const auto back = window.find_last_not_of(continuation_bytes);
+        if (back != std::string_view::npos && static_cast<unsigned char>(window[back]) >= 0xC0) {
+          end = back;
+        }
+      }
+      ingest(window.substr(0, end), threads);
+      return end;
+    });
+  }
+
+  AlphaHistogram& operator+=(const AlphaHistogram& other) {
+    for (size_t i{}; i < letters.size(); i++) letters[i] += other.letters[i];
+    for (auto [c, n] : other.others) others[c] += n;
+    return *this;
+  }
+
+  // Count of an upper-case letter.
+  size_t count(char32_t letter) const {
+    if (letter < letters.size()) return letter ? letters[letter] : 0;
+    const auto found = others.find(letter);
+    return found == others.end() ? 0 : found->second;
+  }
+
+  // Calls fn(letter, count) for the letters seen, in code point order.
+  template <typename Fn>
+  void for_each(Fn fn) const {
+    for (size_t i{ 1 }; i < letters.size(); i++) {
+      if (letters[i]) fn(static_cast<char32_t>(i), letters[i]);
+    }
+    for (auto [c, n] : others) fn(c, n);
+  }
+
+  void print() const {
+    for_each([](char32_t c, size_t n) {
+      printf("%s: ", Utf8::encode(c).c_str());
+      while (n--) printf("*");
+      printf("\n");
+    });
+  }
+
+private:
+  static constexpr size_t minimum_piece = 64 * 1024;
+  static constexpr std::string_view continuation_bytes{
+    "\x80\x81\x82\x83\x84\x85\x86\x87\x88\x89\x8A\x8B\x8C\x8D\x8E\x8F"
+    "\x90\x91\x92\x93\x94\x95\x96\x97\x98\x99\x9A\x9B\x9C\x9D\x9E\x9F"
+    "\xA0\xA1\xA2\xA3\xA4\xA5\xA6\xA7\xA8\xA9\xAA\xAB\xAC\xAD\xAE\xAF"
+    "\xB0\xB1\xB2\xB3\xB4\xB5\xB6\xB7\xB8\xB9\xBA\xBB\xBC\xBD\xBE\xBF" };
+
+  // Upper-case letter of each code point below 0x800, or 0 for non-letters,
+  // so that classifying those is a lookup.
+  static constexpr std::array<uint16_t, 0x800> make_letter_table() {
+    std::array<uint16_t, 0x800> table{};
+    for (char32_t c{}; c < table.size(); c++) {
+      const auto upper = Utf8::to_upper(c);
+      if (Utf8::is_alpha(c) && upper < table.size()) table[c] = static_cast<uint16_t>(upper);
+    }
+    return table;
+  }
+  static const std::array<uint16_t, 0x800> letter_table;
+
+  void add(char32_t c) {
+    if (c < letter_table.size()) {
+      letters[letter_table[c]]++;  // Non-letters land in letters[0], never reported.
+    } else if (Utf8::is_alpha(c)) {
+      others[Utf8::to_upper(c)]++;
+    }
+  }
+
+  // Counts the letters of the leading all-ASCII 32-byte blocks of text, and
+  // returns how many bytes that was.
+  __attribute__((target("avx2")))
+  size_t ingest_ascii_avx2(std::string_view text) {
+    size_t i{};
+    while (i + 32 <= text.size()) {
+      // Up to 255 blocks at a time, so the byte counters can't overflow.
+      size_t blocks{};
+      for (; blocks < 255 && i + 32 * (blocks + 1) <= text.size(); blocks++) {
+        const auto block = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(text.data() + i + 32 * blocks));
+        if (_mm256_movemask_epi8(block)) break;
+      }
+      if (!blocks) break;
+      // 26 counters don't fit in the 16 registers, so half the letters are
+      // counted per pass; the blocks are still in L1 for the second one.
+      count_letters<0>(text.data() + i, blocks);
+      count_letters<13>(text.data() + i, blocks);
+      i += 32 * blocks;
+      if (blocks < 255) break;
+    }
+    return i;
+  }
+
+  template <int first>
+  __attribute__((target("avx2")))
+  void count_letters(const char* data, size_t blocks) {
+    __m256i counters[13];
+    for (auto& counter : counters) counter = _mm256_setzero_si256();
+    const auto case_bit = _mm256_set1_epi8(0x20);
+    for (size_t b{}; b < blocks; b++) {
+      const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32 * b));
+      // Clearing 0x20 maps a-z onto A-Z, and nothing else onto them.
+      const auto upper = _mm256_andnot_si256(case_bit, block);
+      #pragma GCC unroll 13
+      for (int k = 0; k < 13; k++) {
+        counters[k] = _mm256_sub_epi8(
+          counters[k], _mm256_cmpeq_epi8(upper, _mm256_set1_epi8('A' + first + k)));
+      }
+    }
+    for (int k{}; k < 13; k++) {
+      const auto sums = _mm256_sad_epu8(counters[k], _mm256_setzero_si256());
+      letters['A' + first + k] += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                            _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+    }
+  }
+
+  std::array<size_t, 0x800> letters{};  // By code point.
+  std::map<char32_t, size_t> others;
+};
+
+inline constexpr std::array<uint16_t, 0x800> AlphaHistogram::letter_table =
+  AlphaHistogram::make_letter_table();
@@ -0,0 +1,170 @@
+// ---------------------------------------------------------------------------------
+// Streaming word capitalization.
+//
+// Reading every word before writing any keeps the whole input in memory.
+// capitalize_stream reads the input in large blocks, capitalizes the words of
+// each block in place and writes it out, so memory use is a few blocks
+// whatever the input size, and whitespace is kept as it was.
+//
+// Words are found 32 bytes at a time: a nibble-table lookup (see
+// ../ch15/char_class.h) gives the whitespace mask of a block, and a word
+// starts at a non-whitespace byte after whitespace. The block is lowered with
+// the ASCII case kernel, then the letters at word starts are raised again.
+//
+// With double_buffered set, a reader thread and a writer thread do the I/O
+// while the calling thread capitalizes, handing blocks to each other through
+// queues, so reading and writing overlap the computation.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <immintrin.h>
+
+#include "../ch15/ascii_case.h"
+#include "../ch15/char_class.h"
+
+namespace CapitalizeStream {
+
+namespace detail {
+
+// Sets the bytes of a block whose bit is set in mask.
+__attribute__((target("avx2")))
+inline __m256i expand_mask(uint32_t mask) {
+  const auto bytes = _mm256_shuffle_epi8(
+    _mm256_set1_epi32(static_cast<int>(mask)),
+    _mm256_setr_epi64x(0, 0x0101010101010101, 0x0202020202020202, 0x0303030303030303));
+  const auto bits = _mm256_set1_epi64x(static_cast<int64_t>(0x8040201008040201));
+  return _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bits), bits);
+}
+
+__attribute__((target("avx2")))
+inline size_t capitalize_words_avx2(char* data, size_t size, bool& in_word) {
+  const auto& space = CharClasses::space;
+  const auto low = CharClass::nibble_table(space.low_nibbles());
+  const auto high = CharClass::nibble_table(space.high_nibbles());
+  size_t i{};
+  for (; i + 32 <= size; i += 32) {
+    auto* p = reinterpret_cast<__m256i*>(data + i);
+    const auto block = _mm256_loadu_si256(p);
+    const uint32_t word_bytes = ~space.members_mask(block, low, high);
+    const uint32_t starts = word_bytes & ~(word_bytes << 1 | static_cast<uint32_t>(in_word));
+    in_word = word_bytes >> 31;
+
+    const auto lowered = AsciiCase::detail::convert(block, 'A');
+    const auto raised = AsciiCase::detail::convert(lowered, 'a');
+    _mm256_storeu_si256(p, _mm256_blendv_epi8(lowered, raised, expand_mask(starts)));
+  }
+  return i;
+}
+
+}
+
+// Capitalizes the words of data in place: the first letter of each word upper
+// case, the rest lower case. in_word says whether data continues a word, and
+// is updated for the next call.
+inline void capitalize_words(char* data, size_t size, bool& in_word) {
+  size_t i{};
+  if (__builtin_cpu_supports("avx2")) i = detail::capitalize_words_avx2(data, size, in_word);
+  for (; i < size; i++) {
+    const bool is_space = CharClasses::space.contains(data[i]);
+    if (!is_space) data[i] = in_word ? AsciiCase::to_lower(data[i]) : AsciiCase::to_upper(data[i]);
+    in_word = !is_space;
+  }
+}
+
+constexpr size_t block_size = 1 << 20;
+
+struct Block {
+  std::unique_ptr<char[]> data{ new char[block_size] };
+  size_t size{};
+};
+
+// A blocking queue of blocks between two threads.
+class Channel {
+public:
+  void push(Block* block) {
+    {
+      std::lock_guard<std::mutex> lock{ mutex };
+      blocks.push_back(block);
+    }
+    ready.notify_one();
+  }
+
+  Block* pop() {
+    std::unique_lock<std::mutex> lock{ mutex };
+    ready.wait(lock, [this] { return !blocks.empty(); });
+    auto block = blocks.front();
+    blocks.pop_front();
+    return block;
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<Block*> blocks;
+};
+
+inline void capitalize_stream(std::istream& in, std::ostream& out, bool double_buffered = false) {
+  bool in_word{};
+  const auto read = [&in](Block& block) {
+    in.read(block.data.get(), block_size);
+    block.size = static_cast<size_t>(in.gcount());
+  };
+
+  if (!double_buffered) {
+    Block block;
+    for (read(block); block.size; read(block)) {
+      capitalize_words(block.data.get(), block.size, in_word);
+      out.write(block.data.get(), block.size);
+    }
+    return;
+  }
+
+  // Every in.read flushes in.tie() first, and cin is tied to cout: the reader
+  // thread would flush out while the writer thread writes to it. Untied, the
+  // writer is the only thread touching out.
+  const auto tie = in.tie(nullptr);
+
+  // Three blocks circulate: one being read, one capitalized, one written.
+  // An empty block marks the end of the input.
+  std::vector<Block> blocks(3);
+  Channel free_blocks, read_blocks, done_blocks;
+  for (auto& block : blocks) free_blocks.push(&block);
+  std::thread reader{ [&] {
+    size_t size;
+    do {
+      const auto block = free_blocks.pop();
+      read(*block);
+      size = block->size;
+      read_blocks.push(block);
+    } while (size);
+  } };
+  std::thread writer{ [&] {
+    for (auto block = done_blocks.pop(); block->size; block = done_blocks.pop()) {
+      out.write(block->data.get(), block->size);
+      free_blocks.push(block);
+    }
+  } };
+  // Once pushed, a block may be written and refilled, so its size is read
+  // before.
+  size_t size;
+  do {
+    const auto block = read_blocks.pop();
+    size = block->size;
+    capitalize_words(block->data.get(), size, in_word);
+    done_blocks.push(block);
+  } while (size);
+  reader.join();
+  writer.join();
+  in.tie(tie);
+}
+
+}
@@ -334,6 +334,35 @@ void example_ifstream() {
   cout << "Maximum found in numbers.txt was " << maximum << endl;
 }
 
+// NumberReader parses the mapped file in place, a batch at a time, instead of
+// one operator>> call per number (see number_reader.h, tested in
+// number_reader_test.cpp).
+#include "number_reader.h"
+
+void example_number_reader() {
+  NumberReader<int> reader{ "numbers.txt" };
+  auto maximum = numeric_limits<int>::min();
+  for (auto batch = reader.next_batch(); !batch.empty(); batch = reader.next_batch()) {
+    for (auto value : batch) maximum = maximum < value ? value : maximum;
+  }
+  cout << "Maximum found in numbers.txt was " << maximum << endl;
+}
+
+// Text already in memory is read through NumberReader::from_text; read_all
+// parses all of it at once, splitting it between threads at whitespace. A
+// malformed number throws, telling where it is.
+void example_number_reader_text() {
+  string text;
+  for (int i{}; i < 500'000; i++) text += to_string(i % 1000) + (i % 10 ? " " : "\n");
+  const auto numbers = NumberReader<int>::from_text(text).read_all();
+  cout << "Parsed " << numbers.size() << " numbers, the last " << numbers.back() << endl;
+  try {
+    NumberReader<int>::from_text("1 2x 3").read_all();
+  } catch (const invalid_argument& e) {
+    cout << e.what() << endl;
+  }
+}
+
 // File streams fail silently. This open function uses exceptions for checking
 // the open operation occurred fine.
 ifstream open(const char* path, ios_base::openmode mode = ios_base::in) {
@@ -428,59 +457,65 @@ ostream& operator<<(ostream& s, const AutoBrake ab) {
 
 // Exercise 16-2
 
+// Lowers the whole word with the SIMD kernel rather than calling tolower per
+// character, then raises the first letter.
+#include "../ch15/ascii_case.h"
+
 void capitalize(string& str) {
-  str[0] = toupper(str[0]);
-  for (size_t i{ 1 }; i < str.length(); i++) {
-    str[i] = tolower(str[i]);
-  }
+  if (str.empty()) return;
+  AsciiCase::to_lower(str);
+  str[0] = AsciiCase::to_upper(str[0]);
 }
+// Keeping a vector<string> allocates once per (long enough) word. The words
+// are copied into an arena instead, and the vector only holds views of them.
+#include "../ch15/string_pool.h"
+
 void read_capitalize_write() {
-  vector<string> words;
+  StringArena arena;
+  vector<string_view> words;
   string word;
   while (cin >> word) {
     capitalize(word);
-    words.emplace_back(word);
+    words.emplace_back(arena.store(word));
   }
   cout << words;
 }
 
+// Words can also be capitalized where they stand, a block at a time, which
+// keeps the whitespace and needs constant memory (see capitalize_stream.h).
+// Reading and writing happen on their own threads when double_buffered is set.
+#include "capitalize_stream.h"
+
+void stream_capitalize_write(bool double_buffered = false) {
+  ios::sync_with_stdio(false);
+  CapitalizeStream::capitalize_stream(cin, cout, double_buffered);
+  cout.flush();
+}
+
 // Exercise 16-4
 
-#include <map>
+// Counts letters in an array, 32 bytes at a time, and large files in
+// parallel over memory-mapped windows (see alpha_histogram.h).
+#include "alpha_histogram.h"
 
-struct AlphaHistogram {
-  void ingest(string_view str) {
-    for (auto c : str) {
-      if (isalpha(c)) counts[toupper(c)]++;
-    }
-  }
-  void print() const {
-    for (auto [c, n] : counts) {
-      cout << c << ": ";
-      while (n--) cout << "*";
-      cout << endl;
-    }
-  }
-private:
-  std::map<char, size_t> counts;
-};
+// file >> word copies every word into a string, one at a time. WordStatistics
+// scans a memory-mapped file in place, in parallel (see word_statistics.h).
+// An empty file has an average word length of 0, rather than dividing by zero.
+#include "word_statistics.h"
 
 void file_summary(const char* file_name) {
-  AlphaHistogram hist;
-  string word;
-  ifstream file{ file_name };
-
-  int wc{}, len{};
-  while (file >> word) {
-    wc++;
-    len += word.length();
-    hist.ingest(word);
+  WordStatistics stats;
+  try {
+    stats.ingest_file(file_name);
+  } catch (const std::system_error& e) {
+    cerr << e.what() << endl;
+    return;
   }
 
-  cout << "Word count: " << wc
-       << "\nAverage word length: " << len / wc
+  cout << "Word count: " << stats.words
+       << "\nAverage word length: " << stats.average_length()
        << "\nHistogram:\n";
-  hist.print();
+  stats.histogram.print();
 }
 
 // ---------------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+// ---------------------------------------------------------------------------------
+// Memory-mapped file reading.
+//
+// Reading a file through a stream copies every byte from the kernel's page
+// cache into the stream's buffer, and again into the string it's read into.
+// mmap maps the page cache into the address space instead, so the file can be
+// read in place through a std::string_view. Files larger than memory are
+// mapped one window at a time.
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+  static constexpr size_t default_window = size_t{ 256 } << 20;
+
+  explicit MappedFile(const std::string& path) : descriptor{ ::open(path.c_str(), O_RDONLY) } {
+    if (descriptor < 0) throw std::system_error{ errno, std::generic_category(), path };
+    struct stat status;
+    if (::fstat(descriptor, &status) < 0) {
+      const auto error = errno;
+      ::close(descriptor);
+      throw std::system_error{ error, std::generic_category(), path };
+    }
+    file_size = static_cast<size_t>(status.st_size);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    unmap();
+    ::close(descriptor);
+  }
+
+  size_t size() const { return file_size; }
+
+  // Calls fn(window, is_last) over consecutive windows of about window_size
+  // bytes. fn returns how many bytes of the window it consumed; the next
+  // window starts right after them, so fn can leave a token cut by the end of
+  // the window for the next one. A window of which nothing is consumed is
+  // mapped again twice as large. The last window must be consumed whole.
+  template <typename Fn>
+  void for_each_window(Fn fn, size_t window_size = default_window) {
+    const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t offset{};
+    while (offset < file_size) {
+      const auto length = std::min(window_size, file_size - offset);
+      const auto is_last = offset + length == file_size;
+      const auto window = map(offset, length, page);
+      const size_t consumed = fn(window, is_last);
+      if (is_last) break;
+      if (consumed == 0) {
+        window_size *= 2;
+      } else {
+        offset += consumed;
+      }
+    }
+    unmap();
+  }
+
+  // The whole file in one mapping.
+  std::string_view view() {
+    return file_size ? map(0, file_size, static_cast<size_t>(::sysconf(_SC_PAGESIZE)))
+                     : std::string_view{};
+  }
+
+private:
+  // Mappings must start on a page boundary, so the window starts at the page
+  // containing offset.
+  std::string_view map(size_t offset, size_t length, size_t page) {
+    unmap();
+    const auto start = offset / page * page;
+    mapped_length = length + (offset - start);
+    mapped = ::mmap(nullptr, mapped_length, PROT_READ, MAP_PRIVATE, descriptor,
+                    static_cast<off_t>(start));
+    if (mapped == MAP_FAILED) {
+      mapped = nullptr;
+      throw std::system_error{ errno, std::generic_category(), "mmap" };
+    }
+    // The window is read front to back once.
+    ::madvise(mapped, mapped_length, MADV_SEQUENTIAL);
+    return { static_cast<const char*>(mapped) + (offset - start), length };
+  }
+
+  void unmap() {
+    if (mapped) ::munmap(mapped, mapped_length);
+    mapped = nullptr;
+  }
+
+  int descriptor;
+  size_t file_size{};
+  void* mapped{};
+  size_t mapped_length{};
+};
@@ -0,0 +1,182 @@
+// ---------------------------------------------------------------------------------
+// NumberReader: bulk parsing of whitespace-separated numbers.
+//
+// `file >> value` goes through a stream sentry, the locale's num_get facet and
+// the stream buffer for every number. NumberReader maps the file (see
+// mapped_file.h) and parses the text in place with NumberParsing::from_chars
+// (see ../ch15/number_parsing.h), which consumes 8 digits at a time, straight
+// into contiguous storage. Numbers are separated by any whitespace, as for
+// operator>>.
+//
+// next_batch hands out the numbers a batch at a time, as a view of a buffer
+// the reader reuses, so memory use stays bounded; read_all parses the whole
+// text into one vector, splitting it between threads at whitespace.
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../ch15/char_class.h"
+#include "../ch15/number_parsing.h"
+#include "mapped_file.h"
+
+// A view of contiguous elements, standing in for C++20's std::span.
+template <typename T>
+class Span {
+public:
+  Span() = default;
+  Span(T* data, size_t size) : first{ data }, count{ size } {}
+
+  T* data() const { return first; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  T& operator[](size_t i) const { return first[i]; }
+  T* begin() const { return first; }
+  T* end() const { return first + count; }
+
+private:
+  T* first{};
+  size_t count{};
+};
+
+template <typename T>
+class NumberReader {
+  static_assert(std::is_arithmetic_v<T>, "NumberReader parses integers and floating point");
+
+public:
+  static constexpr size_t default_batch = 64 * 1024;
+
+  // Reads the file at path; throws std::system_error if it can't be mapped.
+  explicit NumberReader(const std::string& path)
+      : file{ std::make_unique<MappedFile>(path) }, text{ file->view() } {}
+  explicit NumberReader(const char* path) : NumberReader{ std::string{ path } } {}
+
+  // Reads text itself, which must outlive the reader. A named factory, so a
+  // string holding a path isn't parsed by mistake, or the other way around.
+  static NumberReader from_text(std::string_view text) {
+    NumberReader reader;
+    reader.text = text;
+    return reader;
+  }
+
+  // Parses up to max_size more numbers. The view is valid until the next
+  // call, and empty once the text is exhausted. Throws std::invalid_argument
+  // or std::out_of_range, as NumberParsing::parse does, on a malformed number.
+  Span<const T> next_batch(size_t max_size = default_batch) {
+    batch.resize(max_size);
+    const auto size = parse(position, batch.data(), max_size);
+    return { batch.data(), size };
+  }
+
+  // Parses the rest of the text.
+  std::vector<T> read_all(size_t threads = std::thread::hardware_concurrency()) {
+    const auto rest = text.substr(position);
+    threads = std::max<size_t>(1, std::min(threads, rest.size() / minimum_piece + 1));
+    std::vector<T> result;
+    if (threads == 1) {
+      result.reserve(rest.size() / 8);
+      while (position < text.size()) {
+        const auto old_size = result.size();
+        result.resize(old_size + default_batch);
+        result.resize(old_size + parse(position, result.data() + old_size, default_batch));
+      }
+      return result;
+    }
+
+    // Pieces are cut at whitespace, so no number straddles two of them.
+    std::vector<NumberReader> pieces;
+    std::vector<size_t> offsets;
+    for (size_t t{}, start{}; t < threads; t++) {
+      auto stop = t + 1 == threads ? rest.size() : rest.size() * (t + 1) / threads;
+      stop = std::max(stop, start);
+      while (stop < rest.size() && !CharClasses::space.contains(rest[stop])) stop++;
+      pieces.push_back(from_text(rest.substr(start, stop - start)));
+      offsets.push_back(position + start);
+      start = stop;
+    }
+    std::vector<std::vector<T>> numbers(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (size_t t{}; t < threads; t++) {
+      workers.emplace_back([&, t] {
+        try {
+          pieces[t].base = offsets[t];
+          numbers[t] = pieces[t].read_all(1);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+    for (const auto& error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+    position = text.size();
+
+    size_t total{};
+    for (const auto& piece : numbers) total += piece.size();
+    result.reserve(total);
+    for (const auto& piece : numbers) result.insert(result.end(), piece.begin(), piece.end());
+    return result;
+  }
+
+private:
+  static constexpr size_t minimum_piece = 1 << 20;
+
+  NumberReader() = default;
+
+  static std::from_chars_result parse_number(const char* first, const char* last, T& value) {
+    // NumberParsing has fast paths for integers and doubles only.
+    if constexpr (std::is_same_v<T, float> || std::is_same_v<T, long double>) {
+      return std::from_chars(first, last, value);
+    } else {
+      return NumberParsing::from_chars(first, last, value);
+    }
+  }
+
+  // Parses up to max_size numbers from text[pos] into out, advancing pos past
+  // them, and returns how many there were.
+  size_t parse(size_t& pos, T* out, size_t max_size) const {
+    const auto first = text.data();
+    const auto last = first + text.size();
+    auto p = first + pos;
+    size_t size{};
+    for (; size < max_size; size++) {
+      while (p != last && CharClasses::space.contains(*p)) p++;
+      if (p == last) break;
+      const auto [end, error] = parse_number(p, last, out[size]);
+      if (error == std::errc{} && (end == last || CharClasses::space.contains(*end))) {
+        p = end;
+        continue;
+      }
+      const auto where = " at byte " + std::to_string(base + (p - first));
+      if (error == std::errc::result_out_of_range) throw std::out_of_range{ "Number out of range" + where };
+      throw std::invalid_argument{ "Not a number" + where };
+    }
+    pos = p - first;
+    return size;
+  }
+
+  std::unique_ptr<MappedFile> file;
+  std::string_view text;
+  size_t position{};
+  size_t base{};  // Offset of text in the whole input, for error messages.
+  std::vector<T> batch;
+};
+
+// Parses every number of the file at path.
+template <typename T>
+std::vector<T> read_numbers(const std::string& path,
+                            size_t threads = std::thread::hardware_concurrency()) {
+  return NumberReader<T>{ path }.read_all(threads);
+}
@@ -0,0 +1,48 @@
+// ---------------------------------------------------------------------------------
+// Tests for NumberReader (number_reader.h). Build with `make number_reader_test`
+// and run from this directory, which has numbers.txt.
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <string>
+#include <vector>
+
+#include "number_reader.h"
+
+TEST_CASE("NumberReader") {
+  SECTION("reads a file") {
+    REQUIRE(read_numbers<int>("numbers.txt") == std::vector<int>{ -54, 203, 9000, 0, 99, -789, 400 });
+    REQUIRE_THROWS_AS(NumberReader<int>{ "no_such_file.txt" }, std::system_error);
+  }
+  SECTION("parses numbers separated by any whitespace") {
+    auto reader = NumberReader<int>::from_text("-54\n203\r\n\n 9000 \t0");
+    REQUIRE(reader.read_all() == std::vector<int>{ -54, 203, 9000, 0 });
+  }
+  SECTION("hands out batches") {
+    auto reader = NumberReader<double>::from_text("1.5 -2e3 7 0.25 9");
+    auto batch = reader.next_batch(3);
+    REQUIRE(std::vector<double>(batch.begin(), batch.end()) == std::vector<double>{ 1.5, -2000.0, 7.0 });
+    batch = reader.next_batch(3);
+    REQUIRE(batch.size() == 2);
+    REQUIRE(batch[1] == 9.0);
+    REQUIRE(reader.next_batch(3).empty());
+  }
+  SECTION("gives the same numbers in parallel") {
+    std::string text;
+    std::vector<long> expected;
+    for (long i{}; i < 500'000; i++) {
+      expected.push_back(i * 7919 - 1'000'000);
+      text += std::to_string(expected.back()) + (i % 5 ? " " : "\n");
+    }
+    REQUIRE(NumberReader<long>::from_text(text).read_all(4) == expected);
+  }
+  SECTION("rejects malformed numbers, in parallel too") {
+    REQUIRE_THROWS_AS(NumberReader<int>::from_text("1 2x 3").read_all(), std::invalid_argument);
+    REQUIRE_THROWS_AS(NumberReader<int>::from_text("1 1099511627776").read_all(), std::out_of_range);
+    std::string text;
+    for (int i{}; i < 500'000; i++) text += "12 ";
+    text += "x";
+    REQUIRE_THROWS_WITH(NumberReader<int>::from_text(text).read_all(4),
+                        "Not a number at byte " + std::to_string(text.size() - 1));
+  }
+}
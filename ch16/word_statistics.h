@@ -0,0 +1,135 @@
+// ---------------------------------------------------------------------------------
+// WordStatistics: word count, total word length and letter histogram.
+//
+// Reading words with `file >> word` copies each one into a std::string. Here
+// the file is memory-mapped and scanned in place. Words are runs of
+// non-whitespace bytes, as for operator>>: a nibble-table lookup (see
+// ../ch15/char_class.h) gives a 32-bit whitespace mask per 32-byte block,
+// its popcount the word bytes, and the popcount of the word bytes that follow
+// whitespace the number of words.
+//
+// Pieces of a text cut at whitespace have independent statistics, so large
+// texts are split between threads whose results are added at the end.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <immintrin.h>
+
+#include "../ch15/char_class.h"
+#include "alpha_histogram.h"
+#include "mapped_file.h"
+
+struct WordStatistics {
+  size_t words{}, length{};
+  AlphaHistogram histogram;
+
+  size_t average_length() const { return words ? length / words : 0; }
+
+  // Adds text, which continues the text ingested so far.
+  void ingest(std::string_view text) {
+    // Sub-chunks small enough to still be in cache for the histogram pass.
+    for (size_t pos{}, stop; pos < text.size(); pos = stop) {
+      // Ends at a code point boundary, for the histogram.
+      stop = std::min(text.size(), pos + chunk_size);
+      while (stop < text.size() && (static_cast<unsigned char>(text[stop]) & 0xC0) == 0x80) stop++;
+      const auto chunk = text.substr(pos, stop - pos);
+      count_words(chunk);
+      histogram.ingest(chunk);
+    }
+  }
+
+  // Splits text between threads at whitespace.
+  void ingest(std::string_view text, size_t threads) {
+    threads = std::max<size_t>(1, std::min(threads, text.size() / minimum_piece + 1));
+    if (threads == 1) {
+      ingest(text);
+      return;
+    }
+    // Pieces after the first start at whitespace; the first one may continue
+    // a word from the text before.
+    std::vector<WordStatistics> pieces(threads);
+    pieces[0].in_word = in_word;
+    std::vector<std::thread> workers;
+    size_t start{};
+    for (size_t t{}; t < threads; t++) {
+      auto stop = t + 1 == threads ? text.size() : text.size() * (t + 1) / threads;
+      stop = std::max(stop, start);
+      while (stop < text.size() && !CharClasses::space.contains(text[stop])) stop++;
+      workers.emplace_back([&pieces, t, piece = text.substr(start, stop - start)] {
+        pieces[t].ingest(piece);
+      });
+      start = stop;
+    }
+    for (auto& worker : workers) worker.join();
+    for (const auto& piece : pieces) *this += piece;
+    in_word = !text.empty() && !CharClasses::space.contains(text.back());
+  }
+
+  // Streams the file through memory-mapped windows cut at whitespace.
+  void ingest_file(const std::string& path,
+                   size_t threads = std::thread::hardware_concurrency()) {
+    MappedFile file{ path };
+    file.for_each_window([&](std::string_view window, bool is_last) {
+      auto end = window.size();
+      if (!is_last) {
+        end = 0;
+        for (auto pos = window.size(); pos > 0; pos--) {
+          if (CharClasses::space.contains(window[pos - 1])) {
+            end = pos;
+            break;
+          }
+        }
+      }
+      ingest(window.substr(0, end), threads);
+      return end;
+    });
+  }
+
+  WordStatistics& operator+=(const WordStatistics& other) {
+    words += other.words;
+    length += other.length;
+    histogram += other.histogram;
+    return *this;
+  }
+
+private:
+  static constexpr size_t chunk_size = 64 * 1024;
+  static constexpr size_t minimum_piece = 256 * 1024;
+
+  void count_words(std::string_view text) {
+    size_t i{};
+    if (__builtin_cpu_supports("avx2")) i = count_words_avx2(text);
+    for (; i < text.size(); i++) {
+      const bool is_space = CharClasses::space.contains(text[i]);
+      words += !is_space && !in_word;
+      length += !is_space;
+      in_word = !is_space;
+    }
+  }
+
+  // Counts the whole 32-byte blocks of text, and returns how many bytes that was.
+  __attribute__((target("avx2")))
+  size_t count_words_avx2(std::string_view text) {
+    const auto& space = CharClasses::space;
+    const auto low = CharClass::nibble_table(space.low_nibbles());
+    const auto high = CharClass::nibble_table(space.high_nibbles());
+    size_t i{};
+    for (; i + 32 <= text.size(); i += 32) {
+      const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+      const uint32_t word_bytes = ~space.members_mask(block, low, high);
+      // A word starts at a word byte whose previous byte isn't one.
+      const uint32_t previous = word_bytes << 1 | static_cast<uint32_t>(in_word);
+      words += __builtin_popcount(word_bytes & ~previous);
+      length += __builtin_popcount(word_bytes);
+      in_word = word_bytes >> 31;
+    }
+    return i;
+  }
+
+  bool in_word{};  // Whether the last byte ingested is part of a word.
+};
@@ -0,0 +1,195 @@
+// ---------------------------------------------------------------------------------
+// Faster binary search: branchless lower_bound and friends, a batched
+// lower_bounds, and the Eytzinger layout.
+//
+// std::lower_bound branches on every comparison, and on random queries the
+// branch is a coin toss: each mispredicts half the time, and the next load
+// can't start before the comparison is done. Three ways around it:
+// * Branchless: the range halves whatever the comparison says, and only the
+//   base moves, with a conditional move rather than a branch. The two
+//   possible middles of the next step are prefetched, so the next load is
+//   already on its way.
+// * Batched: lower_bounds searches many queries. Branchless searches of the
+//   same array take the same number of steps, so 16 of them go in lockstep:
+//   their loads are independent, and the memory system serves them in
+//   parallel instead of one miss after another.
+// * Eytzinger: on a large array every search starts with the same few
+//   middles, then misses the cache on every step. Eytzinger is a copy of the
+//   sorted elements in the breadth-first order of the search tree: node k has
+//   children 2k and 2k + 1, so the first levels share a few cache lines, and
+//   the 16 descendants of a node 4 levels down are in one cache line, which is
+//   prefetched 4 steps ahead.
+// binary_search_bench.cpp compares them with std::lower_bound from arrays that
+// fit in L1 to ones that need DRAM.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "parallel_algorithms.h"
+
+namespace BinarySearch {
+
+namespace detail {
+
+// Searches that lower_bounds runs at once.
+constexpr size_t batch = 16;
+
+template <typename It>
+void prefetch(It it) {
+  if constexpr (Parallel::detail::is_contiguous_v<It>) __builtin_prefetch(&*it);
+}
+
+// The first element of [first, first + size) for which goes_right is false,
+// when it's true for a prefix of the range.
+template <typename It, typename GoesRight>
+It partition_point(It first, size_t size, GoesRight goes_right) {
+  if (!size) return first;
+  while (size > 1) {
+    const auto half = size / 2;
+    // The next middle is first + half / 2 or first + half + half / 2.
+    prefetch(first + half / 2);
+    prefetch(first + half + half / 2);
+    first += goes_right(first[half]) ? half : 0;
+    size -= half;
+  }
+  return first + goes_right(*first);
+}
+
+}
+
+template <typename It, typename T, typename Compare = std::less<>>
+It lower_bound(It first, It last, const T& value, Compare comp = {}) {
+  return detail::partition_point(first, last - first,
+                                 [&](const auto& element) { return comp(element, value); });
+}
+
+template <typename It, typename T, typename Compare = std::less<>>
+It upper_bound(It first, It last, const T& value, Compare comp = {}) {
+  return detail::partition_point(first, last - first,
+                                 [&](const auto& element) { return !comp(value, element); });
+}
+
+template <typename It, typename T, typename Compare = std::less<>>
+std::pair<It, It> equal_range(It first, It last, const T& value, Compare comp = {}) {
+  return { BinarySearch::lower_bound(first, last, value, comp),
+           BinarySearch::upper_bound(first, last, value, comp) };
+}
+
+template <typename It, typename T, typename Compare = std::less<>>
+bool binary_search(It first, It last, const T& value, Compare comp = {}) {
+  const auto found = BinarySearch::lower_bound(first, last, value, comp);
+  return found != last && !comp(value, *found);
+}
+
+// Writes the position in [first, last) of the lower_bound of every query to
+// d_first, searching detail::batch queries at a time.
+template <typename It, typename QueryIt, typename OutIt, typename Compare = std::less<>>
+OutIt lower_bounds(It first, It last, QueryIt queries, QueryIt queries_last, OutIt d_first,
+                   Compare comp = {}) {
+  const size_t size = last - first;
+  size_t positions[detail::batch];
+  while (queries != queries_last) {
+    const auto count = std::min<size_t>(detail::batch, queries_last - queries);
+    std::fill(positions, positions + count, 0);
+    for (auto remaining = size; remaining > 1;) {
+      const auto half = remaining / 2;
+      remaining -= half;
+      for (size_t k{}; k < count; k++) {
+        positions[k] += comp(first[positions[k] + half], queries[k]) ? half : 0;
+        // The exact next middle is known now.
+        detail::prefetch(first + positions[k] + remaining / 2);
+      }
+    }
+    for (size_t k{}; k < count; k++) {
+      *d_first++ = positions[k] + (size && comp(first[positions[k]], queries[k]));
+    }
+    queries += count;
+  }
+  return d_first;
+}
+
+// The elements of a sorted range in Eytzinger order, for lower_bound only.
+template <typename T, typename Compare = std::less<>>
+class Eytzinger {
+public:
+  template <typename It>
+  Eytzinger(It first, It last, Compare comp = {})
+    : comp_{ comp }, size_{ static_cast<size_t>(last - first) }, storage_(size_ + 1 + per_line) {
+    // Node 0 is unused; it starts a cache line, so node 16k does too.
+    const auto misalignment = reinterpret_cast<uintptr_t>(storage_.data()) % 64 / sizeof(T);
+    offset_ = misalignment ? per_line - misalignment : 0;
+    fill(first, 1);
+  }
+
+  size_t size() const { return size_; }
+
+  // The first element not less than value, or nullptr.
+  const T* lower_bound(const T& value) const {
+    const auto nodes = this->nodes();
+    size_t k{ 1 };
+    while (k <= size_) {
+      __builtin_prefetch(nodes + std::min(k * per_line, size_));
+      k = 2 * k + comp_(nodes[k], value);
+    }
+    return found(k);
+  }
+
+  // Writes the lower_bound of every query to d_first, in batches as the
+  // lower_bounds above. Searches that are done early take right turns, which
+  // don't change their result.
+  template <typename QueryIt, typename OutIt>
+  OutIt lower_bounds(QueryIt queries, QueryIt queries_last, OutIt d_first) const {
+    const auto nodes = this->nodes();
+    size_t levels{};
+    for (auto n = size_; n; n /= 2) levels++;
+    size_t ks[detail::batch];
+    while (queries != queries_last) {
+      const auto count = std::min<size_t>(detail::batch, queries_last - queries);
+      std::fill(ks, ks + count, 1);
+      for (size_t level{}; level < levels; level++) {
+        for (size_t k{}; k < count; k++) {
+          const auto node = ks[k];
+          ks[k] = 2 * node + (node > size_ || comp_(nodes[std::min(node, size_)], queries[k]));
+          __builtin_prefetch(nodes + std::min(ks[k], size_));
+        }
+      }
+      for (size_t k{}; k < count; k++) *d_first++ = found(ks[k]);
+      queries += count;
+    }
+    return d_first;
+  }
+
+private:
+  static constexpr size_t per_line = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+  T* nodes() { return storage_.data() + offset_; }
+  const T* nodes() const { return storage_.data() + offset_; }
+
+  // In-order, so the sorted elements land in search order.
+  template <typename It>
+  It fill(It it, size_t k) {
+    if (k > size_) return it;
+    it = fill(it, 2 * k);
+    nodes()[k] = *it++;
+    return fill(it, 2 * k + 1);
+  }
+
+  // The search went past a leaf at k: the last left turn, undone by dropping
+  // the right turns after it and then it, was at the lower_bound.
+  const T* found(size_t k) const {
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    return k ? nodes() + k : nullptr;
+  }
+
+  Compare comp_;
+  size_t size_, offset_{};
+  std::vector<T> storage_;
+};
+
+}
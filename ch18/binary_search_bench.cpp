@@ -0,0 +1,87 @@
+// std::lower_bound against the searches of binary_search.h, on sorted random
+// 32-bit keys and 1M random queries, in nanoseconds per query.
+// Build with `make binary_search_bench` (optimized, see Makefile). Arrays go
+// from 4 KB, which fits in L1, to 2^N bytes with `./binary_search_bench N`
+// (default 28, 256 MB, well past the last-level cache); the Eytzinger copy
+// needs as much again.
+
+#include "binary_search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+constexpr size_t query_count{ 1'000'000 };
+
+// Sums what the search finds, so it can't be optimized away and so the
+// searches can be checked against each other.
+template <typename Fn>
+double ns_per_query(Fn search, uint64_t& checksum) {
+  const auto start = std::chrono::steady_clock::now();
+  checksum = search();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() / query_count;
+}
+
+int main(int argc, char** argv) {
+  const auto max_exponent = argc > 1 ? std::atoi(argv[1]) : 28;
+  printf("%12s %12s %12s %12s %12s %12s\n", "bytes", "std", "branchless", "batched", "eytzinger",
+         "eytz batched");
+  std::mt19937 engine{ 42 };
+  std::vector<uint32_t> queries(query_count);
+  for (auto& query : queries) query = engine();
+  std::vector<size_t> positions(query_count);
+  std::vector<const uint32_t*> found(query_count);
+  for (int exponent{ 12 }; exponent <= max_exponent; exponent += 2) {
+    std::vector<uint32_t> keys((size_t{ 1 } << exponent) / sizeof(uint32_t));
+    for (auto& key : keys) key = engine();
+    std::sort(keys.begin(), keys.end());
+    const BinarySearch::Eytzinger<uint32_t> eytzinger{ keys.begin(), keys.end() };
+    const auto key_at = [&](size_t position) { return position < keys.size() ? keys[position] : 0; };
+
+    uint64_t sums[5];
+    printf("%12zu", keys.size() * sizeof(uint32_t));
+    printf(" %10.1fns", ns_per_query([&] {
+             uint64_t sum{};
+             for (auto query : queries) {
+               sum += key_at(std::lower_bound(keys.begin(), keys.end(), query) - keys.begin());
+             }
+             return sum;
+           }, sums[0]));
+    printf(" %10.1fns", ns_per_query([&] {
+             uint64_t sum{};
+             for (auto query : queries) {
+               sum += key_at(BinarySearch::lower_bound(keys.begin(), keys.end(), query) - keys.begin());
+             }
+             return sum;
+           }, sums[1]));
+    printf(" %10.1fns", ns_per_query([&] {
+             BinarySearch::lower_bounds(keys.begin(), keys.end(), queries.begin(), queries.end(),
+                                        positions.begin());
+             uint64_t sum{};
+             for (auto position : positions) sum += key_at(position);
+             return sum;
+           }, sums[2]));
+    printf(" %10.1fns", ns_per_query([&] {
+             uint64_t sum{};
+             for (auto query : queries) {
+               const auto element = eytzinger.lower_bound(query);
+               sum += element ? *element : 0;
+             }
+             return sum;
+           }, sums[3]));
+    printf(" %10.1fns\n", ns_per_query([&] {
+             eytzinger.lower_bounds(queries.begin(), queries.end(), found.begin());
+             uint64_t sum{};
+             for (auto element : found) sum += element ? *element : 0;
+             return sum;
+           }, sums[4]));
+    for (auto sum : sums) {
+      if (sum != sums[0]) {
+        printf("searches disagree!\n");
+        return 1;
+      }
+    }
+  }
+}
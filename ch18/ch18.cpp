@@ -0,0 +1,640 @@
+// ---------------------------------------------------------------------------------
+// Algorithms
+
+#include <algorithm>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+// ---------------------------------------------------------------------------------
+// Execution policies: Some algorithms can have their execution policy specified
+// as either sequential, parallel or parallel vectorized. Sequential and
+// parallel have their usual meanings, pertaining how many entities work to
+// solve a problem. Vectorized execution policy allows entities to perform work
+// in unspecified order, even allowing a single entity to work on multiple
+// portions of a problem.
+
+// The <execution> exposes std::execution::{seq,par,par_unseq} for these.
+// Execution policies are the first argument for stdlib's algorithms, and the
+// default is to use a sequential one.
+
+// libstdc++ runs the parallel policies on TBB. parallel_algorithms.h has a
+// policy of our own, Parallel::par, running on the work-stealing pool of
+// thread_pool.h, with parallel overloads of some algorithms.
+
+#include "parallel_algorithms.h"
+
+TEST_CASE("Parallel execution policy") {
+  ThreadPool pool{ 3 };
+  const auto policy = Parallel::par.on(pool).with_grain(1000);
+  vector<long> values(100'000);
+  iota(values.begin(), values.end(), 0);
+  SECTION("for_each and transform") {
+    Parallel::for_each(policy, values.begin(), values.end(), [](long& value) { value *= 2; });
+    REQUIRE(values[99'999] == 199'998);
+    vector<long> plus_one(values.size());
+    Parallel::transform(policy, values.begin(), values.end(), plus_one.begin(),
+                        [](long value) { return value + 1; });
+    REQUIRE(plus_one[99'999] == 199'999);
+  }
+  SECTION("reduce and transform_reduce") {
+    REQUIRE(Parallel::reduce(policy, values.begin(), values.end()) == 4'999'950'000);
+    REQUIRE(Parallel::transform_reduce(policy, values.begin(), values.end(), values.begin(), 0L) ==
+            inner_product(values.begin(), values.end(), values.begin(), 0L));
+    vector<string> digits(values.size());
+    Parallel::transform(policy, values.begin(), values.end(), digits.begin(),
+                        [](long value) { return to_string(value % 10); });
+    REQUIRE(Parallel::reduce(policy, digits.begin(), digits.end(), string{}) ==
+            accumulate(digits.begin(), digits.end(), string{}));
+  }
+  SECTION("count_if, find_if and copy_if") {
+    const auto is_odd_seventh = [](long value) { return value % 7 == 1; };
+    REQUIRE(Parallel::count_if(policy, values.begin(), values.end(), is_odd_seventh) == 14'286);
+    REQUIRE(*Parallel::find_if(policy, values.begin(), values.end(),
+                               [](long value) { return value > 54'321; }) == 54'322);
+    vector<long> copied(values.size());
+    copied.erase(Parallel::copy_if(policy, values.begin(), values.end(), copied.begin(), is_odd_seventh),
+                 copied.end());
+    REQUIRE(copied.size() == 14'286);
+    REQUIRE(is_sorted(copied.begin(), copied.end()));
+  }
+  SECTION("rethrows exceptions") {
+    REQUIRE_THROWS_AS(Parallel::for_each(policy, values.begin(), values.end(),
+                                         [](long value) {
+                                           if (value == 5'000) throw runtime_error{ "5000" };
+                                         }),
+                      runtime_error);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Non-modifying sequence operations
+
+// all_of: determines if all elements in a sequence meets a predicate.
+
+// any_of: determines if any element in a sequence meets a predicate.
+
+// none_of: determines if no element in a sequence meets a predicate.
+
+// for_each: applies a user-defined function to each element in a sequence.
+
+// for_each_n: applies a user-defined function to the first n elements in a sequence.
+
+// find, find_if and find_if_not: finds the first element matching a predicate.
+
+// find_end: finds last occurence occurrence of a subsequence.
+
+// find_first: finds first occurrence of in a sequence equal to some element in
+// another sequence.
+
+// adjacent_find: finds the first repeat in a sequence.
+
+// count: counts the elements that meets a predicate.
+
+// mismatch: finds first mismatch in two sequences.
+
+// equal: determines whether two sequences are equal.
+
+// is_permutation: determines whether two sequences are permutations.
+
+// search: locates a subsequence.
+
+// std::search also takes a searcher, which preprocesses the needle. Besides
+// std's (in <functional>), searchers.h has a Boyer-Moore-Horspool searcher
+// that skips with AVX2, a two-way searcher that's linear in the worst case,
+// and Searcher, which picks by the needle's length. searchers_bench.cpp
+// compares them.
+
+#include "searchers.h"
+
+TEST_CASE("Searchers") {
+  const string haystack{ "how much wood would a woodchuck chuck if a woodchuck could chuck wood" };
+  const auto position = [&](auto searcher) {
+    return static_cast<size_t>(search(haystack.begin(), haystack.end(), searcher) - haystack.begin());
+  };
+  using It = string::const_iterator;
+  const string needle{ "woodchuck" };
+  SECTION("HorspoolSearcher") {
+    REQUIRE(position(Searchers::HorspoolSearcher<It>{ needle.begin(), needle.end() }) == 22);
+  }
+  SECTION("TwoWaySearcher") {
+    REQUIRE(position(Searchers::TwoWaySearcher<It>{ needle.begin(), needle.end() }) == 22);
+    const string periodic{ "chuck chuck" };
+    REQUIRE(position(Searchers::TwoWaySearcher<It>{ periodic.begin(), periodic.end() }) == 26);
+  }
+  SECTION("Searcher") {
+    const string c{ "c" }, long_needle(100, 'w');
+    REQUIRE(position(Searchers::Searcher<It>{ c.begin(), c.end() }) == 6);
+    REQUIRE(position(Searchers::Searcher<It>{ needle.begin(), needle.end() }) == 22);
+    REQUIRE(position(Searchers::Searcher<It>{ long_needle.begin(), long_needle.end() }) == haystack.size());
+    const vector<int> numbers{ 1, 2, 3, 1, 2, 3, 4 }, pattern{ 2, 3, 4 };
+    using IntIt = vector<int>::const_iterator;
+    REQUIRE(search(numbers.begin(), numbers.end(), Searchers::Searcher<IntIt>{ pattern.begin(), pattern.end() }) ==
+            numbers.begin() + 4);
+  }
+}
+
+// search_n: locates a subsequence containing n identical, consecutive values.
+
+// ---------------------------------------------------------------------------------
+// Mutating sequence operations
+
+// copy: copies one sequence into another.
+
+// copy_n: copies n first elements of a sequence into another.
+
+// copy_backwards: copies the reverse of one sequence into another.
+
+// move: moves one sequence into another.
+
+// move_backward: moves the reverse of one sequence into another.
+
+// swap_ranges: exchanges elements from one sequence into another.
+
+// transform: applies an operation in the elements of one sequence and writes
+// them into another.
+
+// replace: replaces certain elements with some new element.
+
+// fill: fills a sequence with some value.
+
+// generate: fills a sequence by invoking a function object.
+
+// remove: removes certain elements from a sequence.
+
+// unique: removes redundant elements from a sequence.
+
+// reverse: reverses the order of a sequence.
+
+// sample: generates random, stable sequences.
+
+// shuffle: generates random permutations.
+
+// Both draw from one engine, one number after the other. parallel_shuffle.h
+// has parallel versions whose random numbers depend on the seed and the
+// elements' indices only, so they give the same result on any pool.
+
+#include <numeric>
+#include "parallel_shuffle.h"
+
+TEST_CASE("Parallel shuffle and sample") {
+  ThreadPool pool{ 3 }, no_workers{ 0 };
+  const auto policy = Parallel::par.on(pool).with_grain(1000);
+  vector<int> values(300'007);
+  iota(values.begin(), values.end(), 0);
+  SECTION("shuffle permutes the same way on any pool") {
+    auto shuffled = values, serial = values, reseeded = values;
+    Parallel::shuffle(policy, shuffled.begin(), shuffled.end(), 42);
+    Parallel::shuffle(Parallel::par.on(no_workers), serial.begin(), serial.end(), 42);
+    Parallel::shuffle(policy, reseeded.begin(), reseeded.end(), 43);
+    REQUIRE(shuffled == serial);
+    REQUIRE(shuffled != reseeded);
+    REQUIRE(shuffled != values);
+    sort(shuffled.begin(), shuffled.end());
+    REQUIRE(shuffled == values);
+  }
+  SECTION("sample picks the same elements on any pool, in order") {
+    vector<int> sampled, serial;
+    Parallel::sample(policy, values.begin(), values.end(), back_inserter(sampled), 100, 42);
+    Parallel::sample(Parallel::par.on(no_workers), values.begin(), values.end(), back_inserter(serial), 100, 42);
+    REQUIRE(sampled.size() == 100);
+    REQUIRE(sampled == serial);
+    REQUIRE(is_sorted(sampled.begin(), sampled.end()));
+    REQUIRE(adjacent_find(sampled.begin(), sampled.end()) == sampled.end());
+  }
+  SECTION("Reservoirs merge into the reservoir of both streams") {
+    Parallel::Reservoir<int> all{ 10, 7 }, evens{ 10, 7 }, odds{ 10, 7 };
+    for (uint64_t i{}; i < 1000; i++) {
+      all.push(i, static_cast<int>(i));
+      (i % 2 ? odds : evens).push(i, static_cast<int>(i));
+    }
+    evens.merge(odds);
+    REQUIRE(evens.sample() == all.sample());
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Sorting and relates operations
+
+// sort: unstable sort of a sequence.
+
+// stable_sort: stable sort of a sequence.
+
+// partial_sort: sorts a sequence into two groups.
+
+// is_sorted: determines whether a sequence is sorted.
+
+// nth_element: places a particular element in a sequence into its correct
+// sorted position.
+
+// std::execution::par needs TBB with libstdc++. parallel_sort.h has in-house
+// parallel sorts: a radix sort for numbers, a sample sort for any comparison
+// and a stable merge sort. parallel_sort_bench.cpp compares them with std::sort.
+
+#include <random>
+#include "parallel_sort.h"
+
+TEST_CASE("ParallelSort") {
+  std::mt19937 engine{ 42 };
+  SECTION("radix_sort sorts signed integers") {
+    vector<int> values(300'000);
+    for (auto& value : values) value = static_cast<int>(engine());
+    auto expected = values;
+    sort(expected.begin(), expected.end());
+    ParallelSort::radix_sort(values, 4);
+    REQUIRE(values == expected);
+  }
+  SECTION("radix_sort sorts floating point") {
+    vector<double> values(300'000);
+    for (auto& value : values) value = static_cast<int>(engine()) / 1000.0;
+    values[0] = -0.0;
+    values[1] = -1e300;
+    auto expected = values;
+    sort(expected.begin(), expected.end());
+    ParallelSort::radix_sort(values, 4);
+    REQUIRE(values == expected);
+  }
+  SECTION("sample_sort sorts by any comparison") {
+    vector<string> values(300'000);
+    for (auto& value : values) value = to_string(engine() % 1000);
+    auto expected = values;
+    sort(expected.begin(), expected.end(), greater<>{});
+    ParallelSort::sample_sort(values.begin(), values.end(), greater<>{}, 4);
+    REQUIRE(values == expected);
+  }
+  SECTION("stable_sort keeps equal elements in order") {
+    vector<pair<int, size_t>> values(300'000);
+    for (size_t i{}; i < values.size(); i++) values[i] = { engine() % 100, i };
+    const auto by_first = [](const auto& a, const auto& b) { return a.first < b.first; };
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end(), by_first);
+    ParallelSort::stable_sort(values.begin(), values.end(), by_first, 3);
+    REQUIRE(values == expected);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Binary search. Assumes that the target sequence is sorted. 
+
+// lower_bound: finds a partition.
+
+// upper_bound: finds a partition.
+
+// equal_range: finds a range of certain element.
+
+// binary_search: finds a particular element.
+
+// binary_search.h has branchless versions of these, which prefetch the next
+// middle, lower_bounds to search many values at once, and the Eytzinger
+// layout, a breadth-first copy of the sorted elements that keeps the first
+// levels of every search in cache. binary_search_bench.cpp compares them with
+// std::lower_bound.
+
+#include "binary_search.h"
+
+TEST_CASE("BinarySearch") {
+  vector<int> sorted{ 1, 3, 3, 3, 5, 8, 13, 21 };
+  SECTION("lower_bound, upper_bound, equal_range, binary_search") {
+    REQUIRE(BinarySearch::lower_bound(sorted.begin(), sorted.end(), 3) == sorted.begin() + 1);
+    REQUIRE(BinarySearch::upper_bound(sorted.begin(), sorted.end(), 3) == sorted.begin() + 4);
+    const auto [first, last] = BinarySearch::equal_range(sorted.begin(), sorted.end(), 3);
+    REQUIRE(last - first == 3);
+    REQUIRE(BinarySearch::binary_search(sorted.begin(), sorted.end(), 13));
+    REQUIRE_FALSE(BinarySearch::binary_search(sorted.begin(), sorted.end(), 4));
+    REQUIRE(BinarySearch::lower_bound(sorted.begin(), sorted.end(), 22) == sorted.end());
+  }
+  SECTION("lower_bounds") {
+    const vector<int> values{ 0, 3, 4, 21, 22 };
+    vector<size_t> positions(values.size());
+    BinarySearch::lower_bounds(sorted.begin(), sorted.end(), values.begin(), values.end(), positions.begin());
+    REQUIRE(positions == vector<size_t>{ 0, 1, 4, 7, 8 });
+  }
+  SECTION("Eytzinger") {
+    const BinarySearch::Eytzinger<int> eytzinger{ sorted.begin(), sorted.end() };
+    REQUIRE(*eytzinger.lower_bound(4) == 5);
+    REQUIRE(*eytzinger.lower_bound(1) == 1);
+    REQUIRE(eytzinger.lower_bound(22) == nullptr);
+    const vector<int> values{ 2, 9, 30 };
+    vector<const int*> found(values.size());
+    eytzinger.lower_bounds(values.begin(), values.end(), found.begin());
+    REQUIRE(*found[0] == 3);
+    REQUIRE(*found[1] == 13);
+    REQUIRE(found[2] == nullptr);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Partitioning algorithms. A partitioned sequence contains two contiguous,
+// distinct groups of elements. The first element of the second groups is called
+// the partition point.
+
+// is_partitioned: determines whether a sequence is partitioned.
+
+// partition: partitions a sequence according to a predicate.
+
+// partition_copy: partitions and copies them.
+
+// stable_partition: partitions stably.
+
+// stream_compaction.h has parallel, stable versions: the predicate is
+// recorded as a bitmask, block counts give each block its place, and AVX2
+// left-packs each block's elements there (see left_pack.h).
+
+#include "stream_compaction.h"
+
+TEST_CASE("Parallel stream compaction") {
+  ThreadPool pool{ 3 };
+  const auto policy = Parallel::par.on(pool).with_grain(1000);
+  vector<int> values(100'003);
+  for (size_t i{}; i < values.size(); i++) values[i] = static_cast<int>(i * 7919 % 1000);
+  const auto is_small = [](int value) { return value < 300; };
+  SECTION("LeftPack::pack keeps the selected elements in order") {
+    const int in[]{ 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    const uint64_t mask{ 0b1010010110 };
+    int out[5];
+    REQUIRE(LeftPack::pack(in, &mask, 10, out) == 5);
+    REQUIRE(vector<int>(out, out + 5) == vector<int>{ 11, 12, 14, 17, 19 });
+  }
+  SECTION("partition_copy") {
+    vector<int> small(values.size()), large(values.size()), expected_small, expected_large;
+    const auto [small_end, large_end] = Parallel::partition_copy(
+      policy, values.begin(), values.end(), small.begin(), large.begin(), is_small);
+    small.erase(small_end, small.end());
+    large.erase(large_end, large.end());
+    partition_copy(values.begin(), values.end(), back_inserter(expected_small),
+                   back_inserter(expected_large), is_small);
+    REQUIRE(small == expected_small);
+    REQUIRE(large == expected_large);
+  }
+  SECTION("stable_partition and remove_if") {
+    auto expected = values;
+    const auto expected_middle = stable_partition(expected.begin(), expected.end(), is_small);
+    auto partitioned = values;
+    const auto middle = Parallel::stable_partition(policy, partitioned.begin(), partitioned.end(), is_small);
+    REQUIRE(middle - partitioned.begin() == expected_middle - expected.begin());
+    REQUIRE(partitioned == expected);
+
+    expected = values;
+    expected.erase(remove_if(expected.begin(), expected.end(), is_small), expected.end());
+    values.erase(Parallel::remove_if(policy, values.begin(), values.end(), is_small), values.end());
+    REQUIRE(values == expected);
+  }
+  SECTION("moves elements that aren't packable") {
+    vector<string> words{ "keep", "drop", "keep", "keep", "drop" };
+    const auto end = Parallel::remove(policy, words.begin(), words.end(), string{ "drop" });
+    REQUIRE(vector<string>(words.begin(), end) == vector<string>(3, "keep"));
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Merging algorithms. Merges two sorted sequences such that the result is sorted.
+
+// merge: merges two sorted sequences.
+
+// parallel_merge.h has a parallel merge, splitting the output evenly along the
+// merge path, and k-way merges with a loser tree, of runs in memory or of run
+// files too large for it.
+
+#include <cstdio>
+#include <fstream>
+#include "parallel_merge.h"
+
+TEST_CASE("Merging") {
+  vector<int> odds, evens;
+  for (int i{}; i < 20'000; i++) (i % 2 ? odds : evens).push_back(i);
+  SECTION("Parallel::merge") {
+    ThreadPool pool{ 3 };
+    vector<int> merged(odds.size() + evens.size());
+    Parallel::merge(Parallel::par.on(pool).with_grain(1000), odds.begin(), odds.end(), evens.begin(), evens.end(),
+                    merged.begin());
+    REQUIRE(merged[0] == 0);
+    REQUIRE(is_sorted(merged.begin(), merged.end()));
+  }
+  SECTION("KWayMerge::merge is stable") {
+    const vector<pair<int, char>> a{ { 1, 'a' }, { 3, 'a' } }, b{ { 1, 'b' }, { 2, 'b' } }, c{ { 3, 'c' } };
+    using It = vector<pair<int, char>>::const_iterator;
+    const vector<pair<It, It>> runs{ { a.begin(), a.end() }, { b.begin(), b.end() }, { c.begin(), c.end() } };
+    vector<pair<int, char>> merged;
+    KWayMerge::merge(runs, back_inserter(merged), [](const auto& x, const auto& y) { return x.first < y.first; });
+    const vector<pair<int, char>> expected{ { 1, 'a' }, { 1, 'b' }, { 2, 'b' }, { 3, 'a' }, { 3, 'c' } };
+    REQUIRE(merged == expected);
+  }
+  SECTION("KWayMerge::merge_files") {
+    for (const auto& [name, run] : { pair{ "odds.run", &odds }, pair{ "evens.run", &evens } }) {
+      ofstream file{ name, ios::binary };
+      file.write(reinterpret_cast<const char*>(run->data()), run->size() * sizeof(int));
+    }
+    KWayMerge::merge_files<int>({ "odds.run", "evens.run" }, "merged.run", less<>{}, 4096);
+    vector<int> merged(odds.size() + evens.size());
+    ifstream file{ "merged.run", ios::binary };
+    file.read(reinterpret_cast<char*>(merged.data()), merged.size() * sizeof(int));
+    REQUIRE(file.gcount() == 20'000 * sizeof(int));
+    REQUIRE(merged[12'345] == 12'345);
+    REQUIRE(is_sorted(merged.begin(), merged.end()));
+    for (auto name : { "odds.run", "evens.run", "merged.run" }) std::remove(name);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Exteme-value algorithms.
+
+// min and max: determines a sequence's extrema.
+
+// min_element and max_element: determines a sequence's extrema>
+
+// clamp: bounds a value.
+
+// extrema.h vectorizes min_element, max_element and minmax_element, keeping a
+// running extreme and its index in every AVX2 lane, with the same results as
+// std on ties, plus a clamp_range that clamps a whole sequence.
+
+#include <cmath>
+#include "extrema.h"
+
+TEST_CASE("Extrema") {
+  ThreadPool pool{ 3 };
+  const auto policy = Parallel::par.on(pool).with_grain(1000);
+  vector<int> values(100'003);
+  for (size_t i{}; i < values.size(); i++) values[i] = static_cast<int>(i * 7919 % 1000) - 500;
+  SECTION("ties give the first minimum and maximum, like std") {
+    REQUIRE(Extrema::min_element(values.begin(), values.end()) == min_element(values.begin(), values.end()));
+    REQUIRE(Extrema::max_element(values.begin(), values.end()) == max_element(values.begin(), values.end()));
+    REQUIRE(Parallel::min_element(policy, values.begin(), values.end()) ==
+            min_element(values.begin(), values.end()));
+  }
+  SECTION("minmax_element gives the last maximum") {
+    const auto expected = minmax_element(values.begin(), values.end());
+    REQUIRE(Extrema::minmax_element(values.begin(), values.end()) == expected);
+    REQUIRE(Parallel::minmax_element(policy, values.begin(), values.end()) == expected);
+  }
+  SECTION("a NaN falls back to std") {
+    vector<double> doubles{ 3, 1, 4, 1, 5, 9, 2, 6 };
+    doubles[3] = NAN;
+    REQUIRE(Extrema::max_element(doubles.begin(), doubles.end()) == max_element(doubles.begin(), doubles.end()));
+  }
+  SECTION("clamp_range clamps every element") {
+    Parallel::clamp_range(policy, values.begin(), values.end(), -100, 100);
+    REQUIRE(*Extrema::min_element(values.begin(), values.end()) == -100);
+    REQUIRE(*Extrema::max_element(values.begin(), values.end()) == 100);
+    REQUIRE(count(values.begin(), values.end(), 0) == 100);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Numeric operations.
+
+#include <numeric>
+
+// Some of the operations allow to pass an operator to customize behavior.
+// <functional> provides generic class templates for classic operations.
+
+#include <functional>
+
+// iota: fills a sequence with incremental values.
+
+// accumulate: folds a sequence in order.
+
+// reduce: folds a sequence.
+
+// inner_product: computes the inner product of two sequences.
+
+// adjacent_difference: applies an operation to each pair of neighboring elements.
+
+// partial_sum: generates a partal sum.
+
+// parallel_scan.h has parallel versions of the scans, partial_sum's
+// generalizations: a block-wise reduce, a scan of the block totals and a
+// block-wise rescan, with AVX2 for sums of ints and floats.
+
+#include "parallel_scan.h"
+
+TEST_CASE("Parallel scans") {
+  ThreadPool pool{ 3 };
+  const auto policy = Parallel::par.on(pool).with_grain(1000);
+  vector<int> values(100'003);
+  for (size_t i{}; i < values.size(); i++) values[i] = static_cast<int>(i % 17) - 8;
+  vector<int> result(values.size()), expected(values.size());
+  SECTION("inclusive_scan matches partial_sum") {
+    Parallel::inclusive_scan(policy, values.begin(), values.end(), result.begin());
+    partial_sum(values.begin(), values.end(), expected.begin());
+    REQUIRE(result == expected);
+  }
+  SECTION("exclusive_scan works in place") {
+    exclusive_scan(values.begin(), values.end(), expected.begin(), 100);
+    Parallel::exclusive_scan(policy, values.begin(), values.end(), values.begin(), 100);
+    REQUIRE(values == expected);
+  }
+  SECTION("transform_inclusive_scan fuses the transform") {
+    vector<long> squares(values.size()), expected_squares(values.size());
+    const auto square = [](int value) { return static_cast<long>(value) * value; };
+    Parallel::transform_inclusive_scan(policy, values.begin(), values.end(), squares.begin(),
+                                       plus<>{}, square);
+    transform_inclusive_scan(values.begin(), values.end(), expected_squares.begin(), plus<>{}, square);
+    REQUIRE(squares == expected_squares);
+  }
+  SECTION("scans floats and non-commutative operations") {
+    vector<float> floats(values.begin(), values.end()), sums(values.size());
+    Parallel::inclusive_scan(policy, floats.begin(), floats.end(), sums.begin());
+    partial_sum(values.begin(), values.end(), expected.begin());
+    REQUIRE(sums.back() == expected.back());
+    vector<string> digits(300), concatenated(300);
+    for (size_t i{}; i < digits.size(); i++) digits[i] = to_string(i % 10);
+    Parallel::inclusive_scan(policy.with_grain(7), digits.begin(), digits.end(), concatenated.begin());
+    REQUIRE(concatenated[12] == "0123456789012");
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Other algorithms.
+
+// heap operations
+
+// set operations on sorted ranges
+
+// sorted_sets.h has set_intersection, set_union and set_difference for sorted
+// sets of integers, as in an inverted index's posting lists: AVX2 compares
+// whole blocks of two lists of similar sizes, and the elements of a much
+// shorter list are galloped to in the longer one. intersect_all intersects
+// any number of sets.
+
+#include "sorted_sets.h"
+
+TEST_CASE("SortedSets") {
+  vector<uint32_t> evens, threes, big;
+  for (uint32_t i{}; i < 1000; i += 2) evens.push_back(i);
+  for (uint32_t i{}; i < 1000; i += 3) threes.push_back(i);
+  for (uint32_t i{}; i < 100'000; i++) big.push_back(i * 5);
+  vector<uint32_t> result(2000), expected(2000);
+  SECTION("set_intersection") {
+    auto end =
+      SortedSets::set_intersection(evens.begin(), evens.end(), threes.begin(), threes.end(), result.begin());
+    REQUIRE(end - result.begin() == 167);
+    REQUIRE(all_of(result.begin(), end, [](uint32_t x) { return x % 6 == 0; }));
+    end = SortedSets::set_intersection(threes.begin(), threes.end(), big.begin(), big.end(), result.begin());
+    const auto expected_end =
+      set_intersection(threes.begin(), threes.end(), big.begin(), big.end(), expected.begin());
+    REQUIRE(equal(result.begin(), end, expected.begin(), expected_end));
+  }
+  SECTION("set_difference and set_union") {
+    auto end =
+      SortedSets::set_difference(evens.begin(), evens.end(), threes.begin(), threes.end(), result.begin());
+    auto expected_end =
+      set_difference(evens.begin(), evens.end(), threes.begin(), threes.end(), expected.begin());
+    REQUIRE(equal(result.begin(), end, expected.begin(), expected_end));
+    end = SortedSets::set_union(evens.begin(), evens.end(), threes.begin(), threes.end(), result.begin());
+    expected_end = set_union(evens.begin(), evens.end(), threes.begin(), threes.end(), expected.begin());
+    REQUIRE(equal(result.begin(), end, expected.begin(), expected_end));
+  }
+  SECTION("set_difference and set_union of sets of very different sizes") {
+    vector<uint32_t> merged(big.size() + threes.size()), expected_merged(merged.size());
+    auto end = SortedSets::set_difference(big.begin(), big.end(), threes.begin(), threes.end(), merged.begin());
+    auto expected_end =
+      set_difference(big.begin(), big.end(), threes.begin(), threes.end(), expected_merged.begin());
+    REQUIRE(equal(merged.begin(), end, expected_merged.begin(), expected_end));
+    end = SortedSets::set_union(big.begin(), big.end(), threes.begin(), threes.end(), merged.begin());
+    expected_end = set_union(big.begin(), big.end(), threes.begin(), threes.end(), expected_merged.begin());
+    REQUIRE(equal(merged.begin(), end, expected_merged.begin(), expected_end));
+    end = SortedSets::set_union(threes.begin(), threes.end(), big.begin(), big.end(), merged.begin());
+    expected_end = set_union(threes.begin(), threes.end(), big.begin(), big.end(), expected_merged.begin());
+    REQUIRE(equal(merged.begin(), end, expected_merged.begin(), expected_end));
+  }
+  SECTION("64-bit elements") {
+    // Above 2^32, so truncating to 32 bits would give wrong matches.
+    const auto widen = [](const vector<uint32_t>& set) {
+      vector<uint64_t> wide;
+      for (auto x : set) wide.push_back((uint64_t{ x } << 33) + x % 7);
+      return wide;
+    };
+    const auto wide_evens = widen(evens), wide_threes = widen(threes), wide_big = widen(big);
+    vector<uint64_t> wide(wide_big.size()), wide_expected(wide_big.size());
+    auto end = SortedSets::set_intersection(wide_evens.begin(), wide_evens.end(), wide_threes.begin(),
+                                            wide_threes.end(), wide.begin());
+    auto expected_end = set_intersection(wide_evens.begin(), wide_evens.end(), wide_threes.begin(),
+                                         wide_threes.end(), wide_expected.begin());
+    REQUIRE(end - wide.begin() == 167);
+    REQUIRE(equal(wide.begin(), end, wide_expected.begin(), expected_end));
+    end = SortedSets::set_difference(wide_evens.begin(), wide_evens.end(), wide_threes.begin(),
+                                     wide_threes.end(), wide.begin());
+    expected_end = set_difference(wide_evens.begin(), wide_evens.end(), wide_threes.begin(),
+                                  wide_threes.end(), wide_expected.begin());
+    REQUIRE(equal(wide.begin(), end, wide_expected.begin(), expected_end));
+    end = SortedSets::set_difference(wide_big.begin(), wide_big.end(), wide_threes.begin(), wide_threes.end(),
+                                     wide.begin());
+    expected_end = set_difference(wide_big.begin(), wide_big.end(), wide_threes.begin(), wide_threes.end(),
+                                  wide_expected.begin());
+    REQUIRE(equal(wide.begin(), end, wide_expected.begin(), expected_end));
+  }
+  SECTION("intersect_all") {
+    const vector<vector<uint32_t>> sets{ big, evens, threes };
+    const auto common = SortedSets::intersect_all(sets);
+    REQUIRE(common.size() == 34);
+    REQUIRE(common[1] == 30);
+  }
+}
+
+// other numeric algorithms
+
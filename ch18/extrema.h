@@ -0,0 +1,387 @@
+// ---------------------------------------------------------------------------------
+// Vectorized extreme-value algorithms: min_element, max_element,
+// minmax_element and clamp_range.
+//
+// A scalar loop looking for the minimum compares one element at a time, and
+// each comparison waits on the last. With AVX2, every lane of a vector keeps
+// its own running minimum and, in a second vector, the index where it found
+// it: each step compares 8 (or 4) elements against the running minima and
+// blends the smaller values and their indices in. At the end the lanes are
+// reduced to one, breaking ties by index, so the results are std's exactly:
+// the first minimum, the first maximum, and for minmax_element the first
+// minimum and the last maximum. Floating point with NaNs, where the order of
+// comparisons matters, falls back to the std algorithms.
+//
+// Extrema:: has the single-threaded algorithms, for int32, uint32, int64,
+// float and double in contiguous memory (other cases call std). Parallel::
+// has overloads on the execution policy of parallel_algorithms.h, which run
+// them over blocks and combine the blocks' results in order.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <immintrin.h>
+
+#include "parallel_algorithms.h"
+
+namespace Extrema {
+
+namespace detail {
+
+// AVX2 operations on a vector of Ts. less returns a lane mask; indices are
+// 32 bits wide for 8 lanes and 64 bits wide for 4, so masks blend both.
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<int32_t> {
+  static constexpr size_t count = 8;
+  __attribute__((target("avx2"))) static __m256i load(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  __attribute__((target("avx2"))) static void store(int32_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  __attribute__((target("avx2"))) static __m256i broadcast(int32_t x) { return _mm256_set1_epi32(x); }
+  __attribute__((target("avx2"))) static __m256i less(__m256i a, __m256i b) { return _mm256_cmpgt_epi32(b, a); }
+  __attribute__((target("avx2"))) static __m256i blend(__m256i a, __m256i b, __m256i mask) {
+    return _mm256_blendv_epi8(a, b, mask);
+  }
+  __attribute__((target("avx2"))) static __m256i unordered(__m256i) { return _mm256_setzero_si256(); }
+};
+
+template <>
+struct Lanes<uint32_t> : Lanes<int32_t> {
+  __attribute__((target("avx2"))) static __m256i load(const uint32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  __attribute__((target("avx2"))) static void store(uint32_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  __attribute__((target("avx2"))) static __m256i broadcast(uint32_t x) {
+    return _mm256_set1_epi32(static_cast<int32_t>(x));
+  }
+  // No unsigned comparison in AVX2: flipping the sign bits makes it signed.
+  __attribute__((target("avx2"))) static __m256i less(__m256i a, __m256i b) {
+    const auto sign = _mm256_set1_epi32(INT32_MIN);
+    return _mm256_cmpgt_epi32(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+  }
+};
+
+template <>
+struct Lanes<int64_t> {
+  static constexpr size_t count = 4;
+  __attribute__((target("avx2"))) static __m256i load(const int64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  __attribute__((target("avx2"))) static void store(int64_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  __attribute__((target("avx2"))) static __m256i broadcast(int64_t x) { return _mm256_set1_epi64x(x); }
+  __attribute__((target("avx2"))) static __m256i less(__m256i a, __m256i b) { return _mm256_cmpgt_epi64(b, a); }
+  __attribute__((target("avx2"))) static __m256i blend(__m256i a, __m256i b, __m256i mask) {
+    return _mm256_blendv_epi8(a, b, mask);
+  }
+  __attribute__((target("avx2"))) static __m256i unordered(__m256i) { return _mm256_setzero_si256(); }
+};
+
+template <>
+struct Lanes<float> {
+  static constexpr size_t count = 8;
+  __attribute__((target("avx2"))) static __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+  __attribute__((target("avx2"))) static void store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+  __attribute__((target("avx2"))) static __m256 broadcast(float x) { return _mm256_set1_ps(x); }
+  __attribute__((target("avx2"))) static __m256i less(__m256 a, __m256 b) {
+    return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ));
+  }
+  __attribute__((target("avx2"))) static __m256 blend(__m256 a, __m256 b, __m256i mask) {
+    return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(mask));
+  }
+  __attribute__((target("avx2"))) static __m256i unordered(__m256 v) {
+    return _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+  }
+};
+
+template <>
+struct Lanes<double> {
+  static constexpr size_t count = 4;
+  __attribute__((target("avx2"))) static __m256d load(const double* p) { return _mm256_loadu_pd(p); }
+  __attribute__((target("avx2"))) static void store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+  __attribute__((target("avx2"))) static __m256d broadcast(double x) { return _mm256_set1_pd(x); }
+  __attribute__((target("avx2"))) static __m256i less(__m256d a, __m256d b) {
+    return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_LT_OQ));
+  }
+  __attribute__((target("avx2"))) static __m256d blend(__m256d a, __m256d b, __m256i mask) {
+    return _mm256_blendv_pd(a, b, _mm256_castsi256_pd(mask));
+  }
+  __attribute__((target("avx2"))) static __m256i unordered(__m256d v) {
+    return _mm256_castpd_si256(_mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+  }
+};
+
+template <typename T>
+constexpr bool is_vectorized_v = std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+                                 std::is_same_v<T, int64_t> || std::is_same_v<T, float> ||
+                                 std::is_same_v<T, double>;
+
+struct Extremes {
+  size_t min, max;
+};
+
+// Indices 0, 1, ... of each lane, and the step between vectors.
+__attribute__((target("avx2")))
+inline __m256i first_indices(size_t lanes) {
+  return lanes == 8 ? _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) : _mm256_setr_epi64x(0, 1, 2, 3);
+}
+
+__attribute__((target("avx2")))
+inline __m256i next_indices(__m256i indices, size_t lanes) {
+  return lanes == 8 ? _mm256_add_epi32(indices, _mm256_set1_epi32(8))
+                    : _mm256_add_epi64(indices, _mm256_set1_epi64x(4));
+}
+
+__attribute__((target("avx2")))
+inline void store_indices(__m256i indices, size_t lanes, size_t* out) {
+  if (lanes == 8) {
+    uint32_t narrow[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(narrow), indices);
+    std::copy(narrow, narrow + 8, out);
+  } else {
+    uint64_t wide[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(wide), indices);
+    std::copy(wide, wide + 4, out);
+  }
+}
+
+// The index of the first minimum of p[0, size) and of its first maximum, or
+// its last one with last_max; nothing if there is a NaN. size must be at
+// least one vector, and below 2^31.
+template <typename T, bool last_max>
+__attribute__((target("avx2")))
+std::optional<Extremes> extremes_avx2(const T* p, size_t size) {
+  using L = Lanes<T>;
+  constexpr auto lanes = L::count;
+  auto mins = L::load(p), maxs = mins;
+  auto current = first_indices(lanes), min_indices = current, max_indices = current;
+  auto unordered = L::unordered(mins);
+  size_t i{ lanes };
+  for (; i + lanes <= size; i += lanes) {
+    current = next_indices(current, lanes);
+    const auto v = L::load(p + i);
+    unordered = _mm256_or_si256(unordered, L::unordered(v));
+    const auto is_min = L::less(v, mins);
+    mins = L::blend(mins, v, is_min);
+    min_indices = _mm256_blendv_epi8(min_indices, current, is_min);
+    // Greater, or with last_max greater or equal.
+    const auto is_max = last_max ? _mm256_xor_si256(L::less(v, maxs), _mm256_set1_epi32(-1))
+                                 : L::less(maxs, v);
+    maxs = L::blend(maxs, v, is_max);
+    max_indices = _mm256_blendv_epi8(max_indices, current, is_max);
+  }
+  if (!_mm256_testz_si256(unordered, unordered)) return std::nullopt;
+
+  // Every lane's extreme is at a different index, so ties between lanes are
+  // broken by index.
+  T min_values[lanes], max_values[lanes];
+  size_t min_at[lanes], max_at[lanes];
+  L::store(min_values, mins);
+  L::store(max_values, maxs);
+  store_indices(min_indices, lanes, min_at);
+  store_indices(max_indices, lanes, max_at);
+  size_t min_lane{}, max_lane{};
+  for (size_t lane{ 1 }; lane < lanes; lane++) {
+    const auto& value = min_values[lane];
+    const auto& best = min_values[min_lane];
+    if (value < best || (!(best < value) && min_at[lane] < min_at[min_lane])) min_lane = lane;
+    const auto& max_value = max_values[lane];
+    const auto& max_best = max_values[max_lane];
+    const bool later = max_at[lane] > max_at[max_lane];
+    if (max_best < max_value || (!(max_value < max_best) && later == last_max)) max_lane = lane;
+  }
+  Extremes result{ min_at[min_lane], max_at[max_lane] };
+  for (; i < size; i++) {
+    if (p[i] != p[i]) return std::nullopt;
+    if (p[i] < p[result.min]) result.min = i;
+    if (last_max ? !(p[i] < p[result.max]) : p[result.max] < p[i]) result.max = i;
+  }
+  return result;
+}
+
+// Folds the extremes of a later range into those of an earlier one.
+template <bool last_max, typename It>
+void combine(It first, Extremes& result, const Extremes& later) {
+  if (first[later.min] < first[result.min]) result.min = later.min;
+  if (last_max ? !(first[later.max] < first[result.max]) : first[result.max] < first[later.max]) {
+    result.max = later.max;
+  }
+}
+
+// The extremes of [first + begin, first + end), which isn't empty, as in
+// extremes_avx2.
+template <bool last_max, typename It>
+std::optional<Extremes> extremes(It first, size_t begin, size_t end) {
+  using T = typename std::iterator_traits<It>::value_type;
+  if constexpr (is_vectorized_v<T> && Parallel::detail::is_contiguous_v<It>) {
+    constexpr size_t chunk = size_t{ 1 } << 30;
+    if (__builtin_cpu_supports("avx2") && end - begin >= Lanes<T>::count) {
+      std::optional<Extremes> result;
+      for (auto start = begin; start < end; start += chunk) {
+        const auto stop = std::min(end, start + chunk);
+        auto part = stop - start >= Lanes<T>::count ? extremes_avx2<T, last_max>(&*first + start, stop - start)
+                                                    : extremes<last_max>(first, start, stop);
+        if (!part) return std::nullopt;
+        if (stop - start >= Lanes<T>::count) {
+          part->min += start;
+          part->max += start;
+        }
+        if (result) {
+          combine<last_max>(first, *result, *part);
+        } else {
+          result = part;
+        }
+      }
+      return result;
+    }
+  }
+  Extremes result{ begin, begin };
+  for (auto i = begin; i < end; i++) {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (first[i] != first[i]) return std::nullopt;
+    }
+    if (first[i] < first[result.min]) result.min = i;
+    if (last_max ? !(first[i] < first[result.max]) : first[result.max] < first[i]) result.max = i;
+  }
+  return result;
+}
+
+// Clamps the whole vectors of p[0, size) and returns how many elements that was.
+template <typename T>
+__attribute__((target("avx2")))
+size_t clamp_avx2(T* p, size_t size, const T& low, const T& high) {
+  using L = Lanes<T>;
+  const auto lows = L::broadcast(low), highs = L::broadcast(high);
+  size_t i{};
+  for (; i + L::count <= size; i += L::count) {
+    auto v = L::load(p + i);
+    // As std::clamp: v < low ? low : high < v ? high : v.
+    v = L::blend(v, lows, L::less(v, lows));
+    v = L::blend(v, highs, L::less(highs, v));
+    L::store(p + i, v);
+  }
+  return i;
+}
+
+}
+
+// Ranges the AVX2 kernels handle; everything else goes to std.
+template <typename It>
+constexpr bool is_simd_range_v =
+    detail::is_vectorized_v<typename std::iterator_traits<It>::value_type> &&
+    Parallel::detail::is_contiguous_v<It>;
+
+template <typename It>
+It min_element(It first, It last) {
+  if constexpr (is_simd_range_v<It>) {
+    if (first == last) return last;
+    if (const auto result = detail::extremes<false>(first, 0, last - first)) return first + result->min;
+  }
+  return std::min_element(first, last);
+}
+
+template <typename It>
+It max_element(It first, It last) {
+  if constexpr (is_simd_range_v<It>) {
+    if (first == last) return last;
+    if (const auto result = detail::extremes<false>(first, 0, last - first)) return first + result->max;
+  }
+  return std::max_element(first, last);
+}
+
+// The first minimum and the last maximum, like std::minmax_element.
+template <typename It>
+std::pair<It, It> minmax_element(It first, It last) {
+  if constexpr (is_simd_range_v<It>) {
+    if (first == last) return { last, last };
+    if (const auto result = detail::extremes<true>(first, 0, last - first)) {
+      return { first + result->min, first + result->max };
+    }
+  }
+  return std::minmax_element(first, last);
+}
+
+// Clamps every element to [low, high] in place, as std::clamp does.
+template <typename It, typename T>
+void clamp_range(It first, It last, const T& low, const T& high) {
+  using Value = typename std::iterator_traits<It>::value_type;
+  if constexpr (is_simd_range_v<It>) {
+    if (first != last && __builtin_cpu_supports("avx2")) {
+      first += detail::clamp_avx2<Value>(&*first, last - first, low, high);
+    }
+  }
+  for (; first != last; ++first) *first = std::clamp<Value>(*first, low, high);
+}
+
+}
+
+namespace Parallel {
+
+namespace detail {
+
+// The extremes of each block, combined in order; nothing if there is a NaN.
+template <bool last_max, typename It>
+std::optional<Extrema::detail::Extremes> extremes(const ExecutionPolicy& policy, It first, It last) {
+  const auto size = range_size(first, last);
+  std::vector<std::optional<Extrema::detail::Extremes>> blocks(block_count(policy, size));
+  for_each_block(policy, size, [&](size_t block, size_t begin, size_t end) {
+    blocks[block] = Extrema::detail::extremes<last_max>(first, begin, end);
+  });
+  std::optional<Extrema::detail::Extremes> result;
+  for (const auto& block : blocks) {
+    if (!block) return std::nullopt;
+    if (result) {
+      Extrema::detail::combine<last_max>(first, *result, *block);
+    } else {
+      result = block;
+    }
+  }
+  return result;
+}
+
+}
+
+template <typename It>
+It min_element(const ExecutionPolicy& policy, It first, It last) {
+  if (first == last) return last;
+  const auto result = detail::extremes<false>(policy, first, last);
+  return result ? first + result->min : std::min_element(first, last);
+}
+
+template <typename It>
+It max_element(const ExecutionPolicy& policy, It first, It last) {
+  if (first == last) return last;
+  const auto result = detail::extremes<false>(policy, first, last);
+  return result ? first + result->max : std::max_element(first, last);
+}
+
+template <typename It>
+std::pair<It, It> minmax_element(const ExecutionPolicy& policy, It first, It last) {
+  if (first == last) return { last, last };
+  const auto result = detail::extremes<true>(policy, first, last);
+  return result ? std::pair<It, It>{ first + result->min, first + result->max }
+                : std::minmax_element(first, last);
+}
+
+template <typename It, typename T>
+void clamp_range(const ExecutionPolicy& policy, It first, It last, const T& low, const T& high) {
+  detail::for_each_block(policy, detail::range_size(first, last), [&](size_t, size_t begin, size_t end) {
+    Extrema::clamp_range(first + begin, first + end, low, high);
+  });
+}
+
+}
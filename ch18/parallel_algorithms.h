@@ -0,0 +1,276 @@
+// ---------------------------------------------------------------------------------
+// Parallel algorithms on a ThreadPool.
+//
+// The std::execution policies need TBB with libstdc++. Parallel::par is an
+// execution policy of our own, backed by thread_pool.h, taken by the parallel
+// overloads of the algorithms below, which are named and ordered like std's:
+//
+//   Parallel::transform(Parallel::par, in.begin(), in.end(), out.begin(), f);
+//
+// The range is cut in blocks of `grain` elements, one pool task each. The
+// default grain gives every pool thread a few blocks, so faster threads can
+// steal from slower ones; with_grain sets it, and on(pool) picks another pool.
+// Iterators must be random access. Unlike std, where an exception escaping a
+// parallel algorithm calls std::terminate, the first exception is rethrown.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "left_pack.h"
+#include "thread_pool.h"
+
+namespace Parallel {
+
+class ExecutionPolicy {
+public:
+  constexpr ExecutionPolicy() = default;
+
+  // The same policy, running on pool.
+  ExecutionPolicy on(ThreadPool& pool) const {
+    auto result = *this;
+    result.pool_ = &pool;
+    return result;
+  }
+
+  // The same policy, with blocks of grain elements (0 for the default).
+  constexpr ExecutionPolicy with_grain(size_t grain) const {
+    auto result = *this;
+    result.grain_ = grain;
+    return result;
+  }
+
+  ThreadPool& pool() const { return pool_ ? *pool_ : ThreadPool::shared(); }
+
+  // Elements per block for a range of size elements.
+  size_t grain(size_t size) const {
+    if (grain_) return grain_;
+    return std::max<size_t>(minimum_grain, size / (blocks_per_thread * pool().concurrency()));
+  }
+
+private:
+  static constexpr size_t minimum_grain = 4096, blocks_per_thread = 4;
+
+  ThreadPool* pool_{};
+  size_t grain_{};
+};
+
+inline constexpr ExecutionPolicy par{};
+
+namespace detail {
+
+inline size_t block_count(const ExecutionPolicy& policy, size_t size) {
+  const auto grain = policy.grain(size);
+  return (size + grain - 1) / grain;
+}
+
+// Calls fn(block, begin, end) for the blocks of [0, size) on the policy's pool.
+template <typename Fn>
+void for_each_block(const ExecutionPolicy& policy, size_t size, Fn fn) {
+  const auto grain = policy.grain(size);
+  policy.pool().run(block_count(policy, size), [&](size_t block) {
+    fn(block, block * grain, std::min(size, (block + 1) * grain));
+  });
+}
+
+template <typename It>
+size_t range_size(It first, It last) {
+  static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<It>::iterator_category>,
+                "Parallel algorithms need random access iterators");
+  return static_cast<size_t>(last - first);
+}
+
+// Pointers and vector iterators, whose elements are contiguous in memory.
+template <typename It>
+constexpr bool is_contiguous_v =
+  std::is_pointer_v<It> ||
+  std::is_same_v<It, typename std::vector<typename std::iterator_traits<It>::value_type>::iterator> ||
+  std::is_same_v<It, typename std::vector<typename std::iterator_traits<It>::value_type>::const_iterator>;
+
+// The elements of a range matching a predicate, for the stream compaction
+// algorithms (copy_if here, partition and remove_if in stream_compaction.h).
+// A first parallel pass records the predicate of every element as one bit of
+// a mask and counts the matches of each block; the counts of the blocks
+// before a block give where its matches go. A second pass copies each block's
+// matches there, by left-packing (see left_pack.h) when the elements allow it.
+// Blocks are whole mask words, so the grain is rounded up to 64 elements.
+class Selection {
+public:
+  template <typename It, typename Predicate>
+  Selection(const ExecutionPolicy& policy, It first, size_t size, Predicate pred)
+      : size{ size }, masks((size + 63) / 64),
+        policy{ policy.with_grain((policy.grain(size) + 63) / 64) } {
+    offsets.resize(block_count(this->policy, masks.size()) + 1);
+    for_each_block(this->policy, masks.size(), [&](size_t block, size_t begin, size_t end) {
+      size_t count{};
+      for (auto w = begin; w < end; w++) {
+        uint64_t word{};
+        const auto stop = std::min(size, 64 * w + 64);
+        for (auto i = 64 * w; i < stop; i++) word |= uint64_t{ pred(first[i]) ? 1u : 0u } << (i % 64);
+        masks[w] = word;
+        count += __builtin_popcountll(word);
+      }
+      offsets[block + 1] = count;
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  }
+
+  // Number of elements matching.
+  size_t selected() const { return offsets.back(); }
+
+  // Copies the elements matching to d_first, or with matching false, the
+  // others, in order.
+  template <typename It, typename OutIt>
+  void copy_selected(It first, OutIt d_first, bool matching = true) const {
+    using T = typename std::iterator_traits<It>::value_type;
+    using Out = std::remove_reference_t<decltype(*d_first)>;
+    constexpr bool packable = is_contiguous_v<It> && is_contiguous_v<OutIt> && std::is_same_v<T, Out>;
+    for_each_block(policy, masks.size(), [&](size_t block, size_t begin, size_t end) {
+      const auto first_element = 64 * begin;
+      const auto stop = std::min(size, 64 * end);
+      auto offset = matching ? offsets[block] : first_element - offsets[block];
+      std::vector<uint64_t> inverted;
+      const uint64_t* words = masks.data() + begin;
+      if (!matching) {
+        inverted.assign(words, words + (end - begin));
+        for (auto& word : inverted) word = ~word;
+        words = inverted.data();
+      }
+      if constexpr (packable) {
+        LeftPack::pack(&*first + first_element, words, stop - first_element, &*d_first + offset);
+      } else {
+        for (auto i = first_element; i < stop; i++) {
+          if (words[(i - first_element) / 64] >> (i % 64) & 1) d_first[offset++] = first[i];
+        }
+      }
+    });
+  }
+
+private:
+  size_t size;
+  std::vector<uint64_t> masks;
+  ExecutionPolicy policy;        // In mask words.
+  std::vector<size_t> offsets;   // Matches before each block.
+};
+
+}
+
+template <typename It, typename Fn>
+void for_each(const ExecutionPolicy& policy, It first, It last, Fn fn) {
+  detail::for_each_block(policy, detail::range_size(first, last), [&](size_t, size_t begin, size_t end) {
+    std::for_each(first + begin, first + end, fn);
+  });
+}
+
+template <typename It, typename OutIt, typename UnaryOp>
+OutIt transform(const ExecutionPolicy& policy, It first, It last, OutIt d_first, UnaryOp op) {
+  const auto size = detail::range_size(first, last);
+  detail::for_each_block(policy, size, [&](size_t, size_t begin, size_t end) {
+    std::transform(first + begin, first + end, d_first + begin, op);
+  });
+  return d_first + size;
+}
+
+template <typename It1, typename It2, typename OutIt, typename BinaryOp>
+OutIt transform(const ExecutionPolicy& policy, It1 first1, It1 last1, It2 first2, OutIt d_first,
+                BinaryOp op) {
+  const auto size = detail::range_size(first1, last1);
+  detail::for_each_block(policy, size, [&](size_t, size_t begin, size_t end) {
+    std::transform(first1 + begin, first1 + end, first2 + begin, d_first + begin, op);
+  });
+  return d_first + size;
+}
+
+// Folds transform(element) with reduce, in any grouping but in order, so
+// reduce must be associative but needn't be commutative.
+template <typename It, typename T, typename BinaryOp, typename UnaryOp>
+T transform_reduce(const ExecutionPolicy& policy, It first, It last, T init, BinaryOp reduce,
+                   UnaryOp transform) {
+  const auto size = detail::range_size(first, last);
+  std::vector<std::optional<T>> partials(detail::block_count(policy, size));
+  detail::for_each_block(policy, size, [&](size_t block, size_t begin, size_t end) {
+    T partial = transform(first[begin]);
+    for (auto i = begin + 1; i < end; i++) partial = reduce(std::move(partial), transform(first[i]));
+    partials[block] = std::move(partial);
+  });
+  for (auto& partial : partials) init = reduce(std::move(init), std::move(*partial));
+  return init;
+}
+
+template <typename It1, typename It2, typename T, typename BinaryOp1, typename BinaryOp2>
+T transform_reduce(const ExecutionPolicy& policy, It1 first1, It1 last1, It2 first2, T init,
+                   BinaryOp1 reduce, BinaryOp2 transform) {
+  const auto size = detail::range_size(first1, last1);
+  std::vector<std::optional<T>> partials(detail::block_count(policy, size));
+  detail::for_each_block(policy, size, [&](size_t block, size_t begin, size_t end) {
+    T partial = transform(first1[begin], first2[begin]);
+    for (auto i = begin + 1; i < end; i++) {
+      partial = reduce(std::move(partial), transform(first1[i], first2[i]));
+    }
+    partials[block] = std::move(partial);
+  });
+  for (auto& partial : partials) init = reduce(std::move(init), std::move(*partial));
+  return init;
+}
+
+// The inner product of two ranges.
+template <typename It1, typename It2, typename T>
+T transform_reduce(const ExecutionPolicy& policy, It1 first1, It1 last1, It2 first2, T init) {
+  return Parallel::transform_reduce(policy, first1, last1, first2, init, std::plus<>{},
+                                    std::multiplies<>{});
+}
+
+template <typename It, typename T, typename BinaryOp = std::plus<>>
+T reduce(const ExecutionPolicy& policy, It first, It last, T init, BinaryOp op = {}) {
+  return Parallel::transform_reduce(policy, first, last, init, op,
+                                    [](const auto& value) -> T { return value; });
+}
+
+template <typename It>
+typename std::iterator_traits<It>::value_type reduce(const ExecutionPolicy& policy, It first, It last) {
+  return Parallel::reduce(policy, first, last, typename std::iterator_traits<It>::value_type{});
+}
+
+template <typename It, typename Predicate>
+typename std::iterator_traits<It>::difference_type count_if(const ExecutionPolicy& policy, It first,
+                                                             It last, Predicate pred) {
+  using Count = typename std::iterator_traits<It>::difference_type;
+  return Parallel::transform_reduce(policy, first, last, Count{}, std::plus<>{},
+                                    [&pred](const auto& value) -> Count { return pred(value) ? 1 : 0; });
+}
+
+// The first element matching pred. Blocks past a match already found are
+// skipped, so finding something early stops most of the work.
+template <typename It, typename Predicate>
+It find_if(const ExecutionPolicy& policy, It first, It last, Predicate pred) {
+  const auto size = detail::range_size(first, last);
+  std::atomic<size_t> found{ size };
+  detail::for_each_block(policy, size, [&](size_t, size_t begin, size_t end) {
+    for (auto i = begin; i < end && i < found.load(std::memory_order_relaxed); i++) {
+      if (pred(first[i])) {
+        auto current = found.load();
+        while (i < current && !found.compare_exchange_weak(current, i)) {}
+        return;
+      }
+    }
+  });
+  return first + found.load();
+}
+
+// Copies the elements matching pred, in order (see detail::Selection).
+template <typename It, typename OutIt, typename Predicate>
+OutIt copy_if(const ExecutionPolicy& policy, It first, It last, OutIt d_first, Predicate pred) {
+  const detail::Selection selection{ policy, first, detail::range_size(first, last), pred };
+  selection.copy_selected(first, d_first);
+  return d_first + selection.selected();
+}
+
+}
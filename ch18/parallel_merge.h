@@ -0,0 +1,275 @@
+// ---------------------------------------------------------------------------------
+// Merging: a parallel two-way merge, and k-way merges of sorted runs, in
+// memory or in files.
+//
+// Parallel::merge splits the output, not the inputs, in equal blocks. The
+// first d elements of the output are the first i of one input and the first
+// d - i of the other, and i is found with a binary search along the
+// "diagonal" d (the merge path): it's where the two inputs' elements cross.
+// Every block of the output is then merged independently, and all take as
+// long, however the inputs interleave.
+//
+// KWayMerge merges k sorted runs with a loser tree: a tournament whose leaves
+// are the runs' next elements and whose inner nodes remember the loser of
+// their match, the winner moving on. Once the overall winner is output, its
+// run's next element replays only the matches on its way to the root, against
+// the losers stored there: log2(k) comparisons, without the two per level of
+// a binary heap. merge_files merges runs of binary records in files larger
+// than memory, reading every file in large sequential chunks.
+//
+// All merges are stable: of equal elements, those of the earlier input come
+// first.
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parallel_algorithms.h"
+
+namespace Parallel {
+
+namespace detail {
+
+// How many of the first diagonal elements of the merge come from the first
+// input.
+template <typename It1, typename It2, typename Compare>
+size_t merge_path(It1 first1, size_t size1, It2 first2, size_t size2, size_t diagonal, Compare comp) {
+  auto low = diagonal > size2 ? diagonal - size2 : 0;
+  auto high = std::min(diagonal, size1);
+  while (low < high) {
+    const auto middle = low + (high - low) / 2;
+    // The second input goes first only if it's strictly less.
+    if (comp(first2[diagonal - middle - 1], first1[middle])) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+}
+
+template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+OutIt merge(const ExecutionPolicy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first,
+            Compare comp = {}) {
+  const auto size1 = detail::range_size(first1, last1), size2 = detail::range_size(first2, last2);
+  detail::for_each_block(policy, size1 + size2, [&](size_t, size_t begin, size_t end) {
+    const auto from1 = detail::merge_path(first1, size1, first2, size2, begin, comp);
+    const auto to1 = detail::merge_path(first1, size1, first2, size2, end, comp);
+    std::merge(first1 + from1, first1 + to1, first2 + (begin - from1), first2 + (end - to1), d_first + begin,
+               comp);
+  });
+  return d_first + (size1 + size2);
+}
+
+}
+
+namespace KWayMerge {
+
+// A tournament between k sources, given as pointers to their next elements,
+// nullptr for an exhausted one. The nodes keep copies of the elements, so
+// replaying a match doesn't chase pointers into k places of memory; T must
+// be default-constructible.
+template <typename T, typename Compare = std::less<>>
+class LoserTree {
+public:
+  explicit LoserTree(const std::vector<const T*>& heads, Compare comp = {})
+    : comp_{ comp }, size_{ heads.size() }, losers_(std::max<size_t>(1, heads.size())) {
+    // Leaves are k + source; node n's children are 2n and 2n + 1.
+    std::vector<Entry> winners(2 * size_);
+    for (size_t source{}; source < size_; source++) winners[size_ + source] = entry(heads[source], source);
+    for (auto node = size_; node-- > 1;) {
+      auto& a = winners[2 * node];
+      auto& b = winners[2 * node + 1];
+      const auto a_wins = beats(a, b);
+      winners[node] = std::move(a_wins ? a : b);
+      losers_[node] = std::move(a_wins ? b : a);
+    }
+    if (size_) winner_ = std::move(winners[1]);
+  }
+
+  // Whether every source is exhausted.
+  bool empty() const { return winner_.exhausted; }
+
+  // The source of the least element, the first of equal ones.
+  size_t winner() const { return winner_.source; }
+  const T& top() const { return winner_.value; }
+
+  // The winner's source moved on to head, or nullptr once it's exhausted.
+  void replace(const T* head) {
+    winner_ = entry(head, winner_.source);
+    for (auto node = (winner_.source + size_) / 2; node >= 1; node /= 2) {
+      if (beats(losers_[node], winner_)) std::swap(losers_[node], winner_);
+    }
+  }
+
+private:
+  struct Entry {
+    T value{};
+    size_t source{};
+    bool exhausted{ true };
+  };
+
+  static Entry entry(const T* head, size_t source) {
+    return head ? Entry{ *head, source, false } : Entry{ T{}, source, true };
+  }
+
+  bool beats(const Entry& a, const Entry& b) const {
+    if (a.exhausted || b.exhausted) return !a.exhausted;
+    return comp_(a.value, b.value) || (!comp_(b.value, a.value) && a.source < b.source);
+  }
+
+  Compare comp_;
+  size_t size_;
+  std::vector<Entry> losers_;
+  Entry winner_;
+};
+
+// Merges the sorted runs [first, last) to d_first.
+template <typename It, typename OutIt, typename Compare = std::less<>>
+OutIt merge(const std::vector<std::pair<It, It>>& runs, OutIt d_first, Compare comp = {}) {
+  using T = typename std::iterator_traits<It>::value_type;
+  auto positions = runs;
+  std::vector<const T*> heads;
+  for (const auto& [first, last] : runs) heads.push_back(first != last ? &*first : nullptr);
+  LoserTree<T, Compare> tree{ heads, comp };
+  while (!tree.empty()) {
+    auto& [first, last] = positions[tree.winner()];
+    *d_first++ = tree.top();
+    ++first;
+    tree.replace(first != last ? &*first : nullptr);
+  }
+  return d_first;
+}
+
+namespace detail {
+
+// A file of Ts, read sequentially in chunks of a buffer's size.
+template <typename T>
+class RunReader {
+public:
+  RunReader(const std::string& path, size_t buffer_size)
+    : path_{ path }, descriptor_{ ::open(path.c_str(), O_RDONLY) }, buffer_(std::max<size_t>(1, buffer_size)) {
+    if (descriptor_ < 0) throw std::system_error{ errno, std::generic_category(), path };
+    ::posix_fadvise(descriptor_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    refill();
+  }
+
+  RunReader(const RunReader&) = delete;
+  RunReader& operator=(const RunReader&) = delete;
+
+  ~RunReader() { ::close(descriptor_); }
+
+  // The next element, or nullptr at the end of the file.
+  const T* head() const { return next_ < end_ ? &buffer_[next_] : nullptr; }
+
+  const T* advance() {
+    if (++next_ == end_) refill();
+    return head();
+  }
+
+private:
+  void refill() {
+    auto bytes = reinterpret_cast<char*>(buffer_.data());
+    const auto capacity = buffer_.size() * sizeof(T);
+    size_t filled{};
+    while (filled < capacity) {
+      const auto count = ::read(descriptor_, bytes + filled, capacity - filled);
+      if (count < 0 && errno == EINTR) continue;
+      if (count < 0) throw std::system_error{ errno, std::generic_category(), path_ };
+      if (count == 0) break;
+      filled += static_cast<size_t>(count);
+    }
+    if (filled % sizeof(T)) {
+      throw std::system_error{ std::make_error_code(std::errc::invalid_argument),
+                               path_ + ": size isn't a whole number of records" };
+    }
+    next_ = 0;
+    end_ = filled / sizeof(T);
+  }
+
+  std::string path_;
+  int descriptor_;
+  std::vector<T> buffer_;
+  size_t next_{}, end_{};
+};
+
+// Ts buffered and written to a file in chunks of the buffer's size.
+template <typename T>
+class RunWriter {
+public:
+  RunWriter(const std::string& path, size_t buffer_size)
+    : path_{ path }, descriptor_{ ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) } {
+    if (descriptor_ < 0) throw std::system_error{ errno, std::generic_category(), path };
+    buffer_.reserve(std::max<size_t>(1, buffer_size));
+  }
+
+  RunWriter(const RunWriter&) = delete;
+  RunWriter& operator=(const RunWriter&) = delete;
+
+  ~RunWriter() { ::close(descriptor_); }
+
+  void push(const T& value) {
+    buffer_.push_back(value);
+    if (buffer_.size() == buffer_.capacity()) flush();
+  }
+
+  void flush() {
+    auto bytes = reinterpret_cast<const char*>(buffer_.data());
+    auto remaining = buffer_.size() * sizeof(T);
+    while (remaining) {
+      const auto count = ::write(descriptor_, bytes, remaining);
+      if (count < 0 && errno == EINTR) continue;
+      if (count < 0) throw std::system_error{ errno, std::generic_category(), path_ };
+      bytes += count;
+      remaining -= static_cast<size_t>(count);
+    }
+    buffer_.clear();
+  }
+
+private:
+  std::string path_;
+  int descriptor_;
+  std::vector<T> buffer_;
+};
+
+}
+
+// Merges files of sorted binary Ts, as written from memory, into output.
+// memory is split between a read buffer per input and the output's buffer:
+// the larger they are, the fewer and longer the reads, and the less the disk
+// seeks between files.
+template <typename T, typename Compare = std::less<>>
+void merge_files(const std::vector<std::string>& inputs, const std::string& output, Compare comp = {},
+                 size_t memory = size_t{ 256 } << 20) {
+  static_assert(std::is_trivially_copyable_v<T>, "Records are read and written as bytes");
+  const auto buffer_size = memory / (inputs.size() + 1) / sizeof(T);
+  std::vector<std::unique_ptr<detail::RunReader<T>>> readers;
+  std::vector<const T*> heads;
+  for (const auto& input : inputs) {
+    readers.push_back(std::make_unique<detail::RunReader<T>>(input, buffer_size));
+    heads.push_back(readers.back()->head());
+  }
+  detail::RunWriter<T> writer{ output, buffer_size };
+  LoserTree<T, Compare> tree{ heads, comp };
+  while (!tree.empty()) {
+    writer.push(tree.top());
+    tree.replace(readers[tree.winner()]->advance());
+  }
+  writer.flush();
+}
+
+}
@@ -0,0 +1,274 @@
+// ---------------------------------------------------------------------------------
+// Parallel prefix sums: inclusive_scan, exclusive_scan and their transform_
+// versions, on the execution policy of parallel_algorithms.h.
+//
+// A scan looks serial, each output depending on the one before, but it splits
+// into three steps over blocks of the input:
+// 1. every block is reduced to its total, in parallel;
+// 2. the totals are scanned, serially, which gives each block's carry: the
+//    sum of everything before it;
+// 3. every block is scanned again, in parallel, starting from its carry.
+// The input is read twice, which is the price for the parallelism; with a
+// single block or a single thread, steps 1 and 2 are skipped.
+//
+// Sums of int32, uint32 and float are scanned 8 at a time with AVX2: within a
+// vector, adding the vector shifted by one lane, then two, then four gives its
+// prefix sums in three steps, and the carry is then added to all 8 lanes.
+// Like std::inclusive_scan, which is free to regroup the operations, float
+// results can differ from a serial std::partial_sum in the last bits.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include <immintrin.h>
+
+#include "parallel_algorithms.h"
+
+namespace Parallel {
+
+namespace detail {
+
+struct Identity {
+  template <typename T>
+  T&& operator()(T&& value) const { return std::forward<T>(value); }
+};
+
+// Whether a scan of It into OutIt by op and transform, with values of type T,
+// is a sum the AVX2 kernels below handle.
+template <typename T, typename It, typename OutIt, typename BinaryOp, typename UnaryOp>
+constexpr bool is_simd_sum() {
+  using In = typename std::iterator_traits<It>::value_type;
+  using Out = std::remove_reference_t<decltype(*std::declval<OutIt>())>;
+  return is_contiguous_v<It> && is_contiguous_v<OutIt> && std::is_same_v<T, In> &&
+         std::is_same_v<T, Out> &&
+         (std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> || std::is_same_v<T, float>) &&
+         (std::is_same_v<BinaryOp, std::plus<>> || std::is_same_v<BinaryOp, std::plus<T>>) &&
+         std::is_same_v<UnaryOp, Identity>;
+}
+
+// Lane-wise sums, for int32/uint32 (as __m256i) and float (as __m256).
+__attribute__((target("avx2")))
+inline __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+__attribute__((target("avx2")))
+inline __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+
+template <typename T>
+struct VectorOf {
+  using type = __m256i;
+};
+template <>
+struct VectorOf<float> {
+  using type = __m256;
+};
+template <typename T>
+using Vector = typename VectorOf<T>::type;
+
+template <typename T>
+__attribute__((target("avx2")))
+Vector<T> load(const T* p) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm256_loadu_ps(p);
+  } else {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+void store(T* p, Vector<T> v) {
+  if constexpr (std::is_same_v<T, float>) {
+    _mm256_storeu_ps(p, v);
+  } else {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+}
+
+// Bit casts between the two vector types, so the shuffles are written once.
+__attribute__((target("avx2")))
+inline __m256i as_integers(__m256i v) { return v; }
+__attribute__((target("avx2")))
+inline __m256i as_integers(__m256 v) { return _mm256_castps_si256(v); }
+template <typename T>
+__attribute__((target("avx2")))
+Vector<T> from_integers(__m256i v) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm256_castsi256_ps(v);
+  } else {
+    return v;
+  }
+}
+
+// The prefix sums of the 8 lanes of v.
+template <typename T>
+__attribute__((target("avx2")))
+Vector<T> scan_lanes(Vector<T> v) {
+  const auto zero = _mm256_setzero_si256();
+  // Shifts within each 128-bit half: one lane, then two.
+  v = add(v, from_integers<T>(_mm256_alignr_epi8(as_integers(v), zero, 12)));
+  v = add(v, from_integers<T>(_mm256_alignr_epi8(as_integers(v), zero, 8)));
+  // Then the low half's last lane goes to every lane of the high half.
+  const auto low_total = _mm256_permutevar8x32_epi32(as_integers(v), _mm256_set1_epi32(3));
+  return add(v, from_integers<T>(_mm256_blend_epi32(zero, low_total, 0xF0)));
+}
+
+// Writes the prefix sums of in[0, size) plus carry to out, and returns the
+// total. Handles whole vectors only; returns how far it got in done.
+template <typename T>
+__attribute__((target("avx2")))
+T scan_sum_avx2(const T* in, T* out, size_t size, T carry, bool inclusive, size_t& done) {
+  const T broadcast[8] = { carry, carry, carry, carry, carry, carry, carry, carry };
+  auto carries = load(broadcast);
+  const auto shift_one = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+  const auto last = _mm256_set1_epi32(7);
+  size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto sums = add(scan_lanes<T>(load(in + i)), carries);
+    if (inclusive) {
+      store(out + i, sums);
+    } else {
+      // Each lane gets the sum before it: one lane over, with the carry first.
+      const auto shifted = _mm256_permutevar8x32_epi32(as_integers(sums), shift_one);
+      store(out + i, from_integers<T>(_mm256_blend_epi32(shifted, as_integers(carries), 0x01)));
+    }
+    carries = from_integers<T>(_mm256_permutevar8x32_epi32(as_integers(sums), last));
+  }
+  done = i;
+  T lanes[8];
+  store(lanes, carries);
+  return lanes[0];
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+T sum_avx2(const T* in, size_t size, size_t& done) {
+  auto sums = from_integers<T>(_mm256_setzero_si256());
+  size_t i{};
+  for (; i + 8 <= size; i += 8) sums = add(sums, load(in + i));
+  done = i;
+  T lanes[8];
+  store(lanes, sums);
+  T total{};
+  for (auto lane : lanes) total += lane;
+  return total;
+}
+
+// Scans [begin, end) of the input into the output, starting from carry if
+// there is one, and returns the running value after the block.
+template <bool inclusive, typename It, typename OutIt, typename T, typename BinaryOp, typename UnaryOp>
+std::optional<T> scan_block(It first, OutIt d_first, size_t begin, size_t end, std::optional<T> carry,
+                            BinaryOp op, UnaryOp transform) {
+  if constexpr (is_simd_sum<T, It, OutIt, BinaryOp, UnaryOp>()) {
+    if (__builtin_cpu_supports("avx2") && end - begin >= 8) {
+      size_t done;
+      carry = scan_sum_avx2<T>(&*first + begin, &*d_first + begin, end - begin,
+                               carry.value_or(T{}), inclusive, done);
+      begin += done;
+    }
+  }
+  for (auto i = begin; i < end; i++) {
+    T value = transform(first[i]);
+    if constexpr (inclusive) {
+      carry = carry ? op(std::move(*carry), std::move(value)) : std::move(value);
+      d_first[i] = *carry;
+    } else {
+      d_first[i] = *carry;
+      carry = op(std::move(*carry), std::move(value));
+    }
+  }
+  return carry;
+}
+
+template <typename T, typename It, typename BinaryOp, typename UnaryOp>
+T reduce_block(It first, size_t begin, size_t end, BinaryOp op, UnaryOp transform) {
+  if constexpr (is_simd_sum<T, It, T*, BinaryOp, UnaryOp>()) {
+    if (__builtin_cpu_supports("avx2") && end - begin >= 8) {
+      size_t done;
+      T total = sum_avx2<T>(&*first + begin, end - begin, done);
+      for (auto i = begin + done; i < end; i++) total = op(total, first[i]);
+      return total;
+    }
+  }
+  T total = transform(first[begin]);
+  for (auto i = begin + 1; i < end; i++) total = op(std::move(total), transform(first[i]));
+  return total;
+}
+
+template <bool inclusive, typename T, typename It, typename OutIt, typename BinaryOp, typename UnaryOp>
+OutIt scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first, std::optional<T> init,
+           BinaryOp op, UnaryOp transform) {
+  const auto size = range_size(first, last);
+  const auto blocks = block_count(policy, size);
+  // Without a second thread, the two passes would only cost time.
+  if (blocks <= 1 || policy.pool().concurrency() == 1) {
+    scan_block<inclusive>(first, d_first, 0, size, std::move(init), op, transform);
+    return d_first + size;
+  }
+
+  const auto grain = policy.grain(size);
+  std::vector<std::optional<T>> carries(blocks);
+  // The last block's total isn't needed.
+  policy.pool().run(blocks - 1, [&](size_t block) {
+    carries[block + 1] = reduce_block<T>(first, block * grain, (block + 1) * grain, op, transform);
+  });
+  carries[0] = std::move(init);
+  for (size_t block{ 1 }; block < blocks; block++) {
+    if (carries[block - 1]) carries[block] = op(*carries[block - 1], std::move(*carries[block]));
+  }
+  for_each_block(policy, size, [&](size_t block, size_t begin, size_t end) {
+    scan_block<inclusive>(first, d_first, begin, end, carries[block], op, transform);
+  });
+  return d_first + size;
+}
+
+}
+
+template <typename It, typename OutIt, typename BinaryOp = std::plus<>>
+OutIt inclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first,
+                     BinaryOp op = {}) {
+  using T = typename std::iterator_traits<It>::value_type;
+  return detail::scan<true, T>(policy, first, last, d_first, std::nullopt, op, detail::Identity{});
+}
+
+template <typename It, typename OutIt, typename BinaryOp, typename T>
+OutIt inclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first, BinaryOp op,
+                     T init) {
+  return detail::scan<true, T>(policy, first, last, d_first, std::optional<T>{ std::move(init) }, op,
+                               detail::Identity{});
+}
+
+template <typename It, typename OutIt, typename T, typename BinaryOp = std::plus<>>
+OutIt exclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first, T init,
+                     BinaryOp op = {}) {
+  return detail::scan<false, T>(policy, first, last, d_first, std::optional<T>{ std::move(init) }, op,
+                                detail::Identity{});
+}
+
+// inclusive_scan of transform(element), without storing the transformed
+// elements anywhere.
+template <typename It, typename OutIt, typename BinaryOp, typename UnaryOp>
+OutIt transform_inclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first,
+                               BinaryOp op, UnaryOp transform) {
+  using T = std::decay_t<std::invoke_result_t<UnaryOp, typename std::iterator_traits<It>::reference>>;
+  return detail::scan<true, T>(policy, first, last, d_first, std::nullopt, op, transform);
+}
+
+template <typename It, typename OutIt, typename BinaryOp, typename UnaryOp, typename T>
+OutIt transform_inclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first,
+                               BinaryOp op, UnaryOp transform, T init) {
+  return detail::scan<true, T>(policy, first, last, d_first, std::optional<T>{ std::move(init) }, op,
+                               transform);
+}
+
+template <typename It, typename OutIt, typename T, typename BinaryOp, typename UnaryOp>
+OutIt transform_exclusive_scan(const ExecutionPolicy& policy, It first, It last, OutIt d_first,
+                               T init, BinaryOp op, UnaryOp transform) {
+  return detail::scan<false, T>(policy, first, last, d_first, std::optional<T>{ std::move(init) }, op,
+                                transform);
+}
+
+}
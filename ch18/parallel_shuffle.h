@@ -0,0 +1,194 @@
+// ---------------------------------------------------------------------------------
+// Parallel, reproducible randomness: shuffle and sample.
+//
+// std::shuffle and std::sample draw from one engine, one number after the
+// other, so they're serial, and splitting the engine between threads would
+// make the result depend on how many there are. Here every random number is
+// instead a function of the seed and of what it's for, such as the element's
+// index: a counter-based generator, SplitMix64's mixing function applied to
+// seed + index. Whichever thread draws it, it's the same number, so given a
+// seed the results are the same on any pool, with any grain.
+//
+// Parallel::shuffle scatters the elements into buckets, each element's bucket
+// drawn at random, then Fisher-Yates shuffles every bucket, in parallel. That
+// is a uniformly random permutation: random buckets, then a random order in
+// each. The scatter goes through a buffer, so the elements must be
+// default-constructible, as in stream_compaction.h.
+//
+// Reservoir keeps a uniform sample of k elements of a stream: each element
+// gets a random key drawn for its index, and the sample is the k elements
+// with the smallest keys. Two reservoirs of the same stream merge into the
+// one for both their elements, so Parallel::sample fills one per block and
+// merges them.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "parallel_algorithms.h"
+
+namespace Parallel {
+
+namespace detail {
+
+constexpr uint64_t golden_gamma = 0x9e3779b97f4a7c15;
+
+// SplitMix64's output function.
+inline uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+// The index-th random number of the stream seeded with seed.
+inline uint64_t random_at(uint64_t seed, uint64_t index) { return mix(seed + (index + 1) * golden_gamma); }
+
+// A random number in [0, bound), from a 64-bit one: the high half of their
+// product, biased by at most bound / 2^64.
+inline uint64_t below(uint64_t random, uint64_t bound) {
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(random) * bound) >> 64);
+}
+
+// The same numbers, drawn in order.
+class SplitMix64 {
+public:
+  explicit SplitMix64(uint64_t seed) : state_{ seed } {}
+
+  uint64_t operator()() { return mix(state_ += golden_gamma); }
+
+private:
+  uint64_t state_;
+};
+
+// Elements per bucket, about what a Fisher-Yates shuffle does in cache, and
+// per scatter task. Both depend on the size only, never on the pool.
+constexpr size_t shuffle_bucket = size_t{ 1 } << 18;
+constexpr size_t shuffle_chunk = size_t{ 1 } << 22;
+
+}
+
+// Shuffles [first, last) at random, the same for the same seed on any pool.
+template <typename It>
+void shuffle(const ExecutionPolicy& policy, It first, It last, uint64_t seed) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const auto size = detail::range_size(first, last);
+  if (size < 2) return;
+  const auto buckets = (size + detail::shuffle_bucket - 1) / detail::shuffle_bucket;
+  const auto chunks = (size + detail::shuffle_chunk - 1) / detail::shuffle_chunk;
+  // Separate streams for the buckets and for the orders within them.
+  const auto scatter_seed = detail::mix(seed), order_seed = detail::mix(~seed);
+  const auto bucket_of = [&](size_t i) { return detail::below(detail::random_at(scatter_seed, i), buckets); };
+  const auto chunk_end = [&](size_t chunk) { return std::min(size, (chunk + 1) * detail::shuffle_chunk); };
+  auto& pool = policy.pool();
+
+  // Where each chunk's elements of each bucket go: buckets in order, and in
+  // each bucket the chunks in order.
+  std::vector<size_t> cursors(chunks * buckets);
+  pool.run(chunks, [&](size_t chunk) {
+    for (auto i = chunk * detail::shuffle_chunk; i < chunk_end(chunk); i++) cursors[chunk * buckets + bucket_of(i)]++;
+  });
+  std::vector<size_t> starts(buckets + 1);
+  size_t running{};
+  for (size_t bucket{}; bucket < buckets; bucket++) {
+    starts[bucket] = running;
+    for (size_t chunk{}; chunk < chunks; chunk++) {
+      running += std::exchange(cursors[chunk * buckets + bucket], running);
+    }
+  }
+  starts[buckets] = size;
+
+  std::vector<T> buffer(size);
+  pool.run(chunks, [&](size_t chunk) {
+    const auto chunk_cursors = cursors.data() + chunk * buckets;
+    for (auto i = chunk * detail::shuffle_chunk; i < chunk_end(chunk); i++) {
+      buffer[chunk_cursors[bucket_of(i)]++] = std::move(first[i]);
+    }
+  });
+  pool.run(buckets, [&](size_t bucket) {
+    detail::SplitMix64 random{ detail::random_at(order_seed, bucket) };
+    const auto begin = buffer.begin() + starts[bucket], end = buffer.begin() + starts[bucket + 1];
+    for (auto n = end - begin; n > 1; n--) {
+      std::iter_swap(begin + (n - 1), begin + detail::below(random(), n));
+    }
+    std::move(begin, end, first + starts[bucket]);
+  });
+}
+
+// A uniform sample of up to capacity elements of a stream, each pushed with
+// its index in the stream.
+template <typename T>
+class Reservoir {
+public:
+  Reservoir(size_t capacity, uint64_t seed) : capacity_{ capacity }, seed_{ detail::mix(seed) } {}
+
+  void push(uint64_t index, const T& value) {
+    if (!capacity_) return;
+    const auto key = detail::random_at(seed_, index);
+    if (entries_.size() < capacity_) {
+      entries_.push({ key, index, value });
+    } else if (Entry::less(key, index, entries_.top())) {
+      entries_.pop();
+      entries_.push({ key, index, value });
+    }
+  }
+
+  // Adds other's elements, from the same stream and seed, as if pushed here.
+  void merge(const Reservoir& other) {
+    auto others = other.entries_;
+    for (; !others.empty(); others.pop()) {
+      const auto& entry = others.top();
+      push(entry.index, entry.value);
+    }
+  }
+
+  // The sample, in stream order.
+  std::vector<T> sample() const {
+    std::vector<Entry> sorted;
+    for (auto copy = entries_; !copy.empty(); copy.pop()) sorted.push_back(copy.top());
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.index < b.index; });
+    std::vector<T> values;
+    for (auto& entry : sorted) values.push_back(std::move(entry.value));
+    return values;
+  }
+
+private:
+  struct Entry {
+    uint64_t key, index;
+    T value;
+
+    static bool less(uint64_t key, uint64_t index, const Entry& other) {
+      return key < other.key || (key == other.key && index < other.index);
+    }
+
+    bool operator<(const Entry& other) const { return less(key, index, other); }
+  };
+
+  size_t capacity_;
+  uint64_t seed_;
+  // The largest key on top, the first to go.
+  std::priority_queue<Entry> entries_;
+};
+
+// Copies a uniform sample of count elements of [first, last), or all of them
+// if there are fewer, to d_first in order, like std::sample; the same for the
+// same seed on any pool.
+template <typename It, typename OutIt>
+OutIt sample(const ExecutionPolicy& policy, It first, It last, OutIt d_first, size_t count, uint64_t seed) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const auto size = detail::range_size(first, last);
+  std::vector<Reservoir<T>> reservoirs(detail::block_count(policy, size), Reservoir<T>{ count, seed });
+  detail::for_each_block(policy, size, [&](size_t block, size_t begin, size_t end) {
+    for (auto i = begin; i < end; i++) reservoirs[block].push(i, first[i]);
+  });
+  Reservoir<T> merged{ count, seed };
+  for (const auto& reservoir : reservoirs) merged.merge(reservoir);
+  const auto values = merged.sample();
+  return std::copy(values.begin(), values.end(), d_first);
+}
+
+}
@@ -0,0 +1,268 @@
+// ---------------------------------------------------------------------------------
+// Parallel sorting.
+//
+// libstdc++ implements std::execution::par with TBB, so without it the
+// parallel overloads of std::sort don't build. These sorts split the work
+// between std::threads themselves:
+// * radix_sort sorts integers and floating point by their bits, least
+//   significant byte first (LSD). Each pass counts the bytes of every thread's
+//   slice, which gives each thread where its elements go, and then the threads
+//   scatter them in parallel. Passes whose byte is the same for every element
+//   are skipped. No comparisons at all, which for large arrays beats
+//   std::sort's n log n.
+// * sample_sort sorts with any comparison. A sorted sample of the elements
+//   picks a splitter per thread, every element is moved into the bucket
+//   between two splitters, and the buckets are then sorted independently.
+// * stable_sort stable-sorts a slice per thread and merges the sorted slices
+//   pairwise until one run is left. Every round's output is split in a slice
+//   per thread along the merge path (see parallel_merge.h), so even the last
+//   round, a single merge, keeps all the threads busy.
+// The last two move elements into a buffer, so they need default-constructible
+// element types.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "parallel_merge.h"
+
+namespace ParallelSort {
+
+namespace detail {
+
+// Below this many elements per thread, threads cost more than they save.
+constexpr size_t minimum_piece = 1 << 16;
+
+inline size_t thread_count(size_t size, size_t threads) {
+  return std::max<size_t>(1, std::min(threads, size / minimum_piece));
+}
+
+// Calls fn(t) for each t in [0, tasks), the last one on the calling thread.
+template <typename Fn>
+void run_tasks(size_t tasks, Fn fn) {
+  std::vector<std::thread> workers;
+  for (size_t t{}; t + 1 < tasks; t++) workers.emplace_back(fn, t);
+  if (tasks) fn(tasks - 1);
+  for (auto& worker : workers) worker.join();
+}
+
+// Start of slice t of [0, size) split in slices parts.
+inline size_t slice_start(size_t size, size_t slices, size_t t) { return size * t / slices; }
+
+// Maps a key to an unsigned integer of the same size and the same order.
+template <typename T>
+auto radix_key(T value) {
+  if constexpr (std::is_floating_point_v<T>) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "float and double only");
+    using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    // Negative numbers order backwards, so all their bits flip; positive ones
+    // just move above them.
+    constexpr auto sign = Bits{ 1 } << (8 * sizeof(T) - 1);
+    return bits & sign ? static_cast<Bits>(~bits) : static_cast<Bits>(bits | sign);
+  } else {
+    using Bits = std::make_unsigned_t<T>;
+    constexpr auto sign = std::is_signed_v<T> ? Bits{ 1 } << (8 * sizeof(T) - 1) : Bits{};
+    return static_cast<Bits>(static_cast<Bits>(value) ^ sign);
+  }
+}
+
+}
+
+// Sorts data[0, size) in ascending order.
+template <typename T>
+void radix_sort(T* data, size_t size, size_t threads = std::thread::hardware_concurrency()) {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "radix_sort sorts integers and floating point");
+  if (size < 4096) {
+    std::sort(data, data + size);
+    return;
+  }
+  threads = detail::thread_count(size, threads);
+  std::vector<T> buffer(size);
+  T* from = data;
+  T* to = buffer.data();
+  std::vector<std::array<size_t, 256>> counts(threads);
+  for (size_t pass{}; pass < sizeof(T); pass++) {
+    const auto shift = 8 * pass;
+    const auto digit = [shift](T value) { return (detail::radix_key(value) >> shift) & 0xFF; };
+    detail::run_tasks(threads, [&](size_t t) {
+      counts[t].fill(0);
+      const auto stop = detail::slice_start(size, threads, t + 1);
+      for (auto i = detail::slice_start(size, threads, t); i < stop; i++) counts[t][digit(from[i])]++;
+    });
+
+    // Turns the counts into where each thread's first element of each digit
+    // goes: digits in order, and within a digit the threads in order, which
+    // keeps each pass stable.
+    size_t offset{};
+    bool skip{};
+    for (size_t d{}; d < 256; d++) {
+      size_t total{};
+      for (size_t t{}; t < threads; t++) {
+        const auto count = counts[t][d];
+        counts[t][d] = offset + total;
+        total += count;
+      }
+      skip |= total == size;
+      offset += total;
+    }
+    if (skip) continue;
+
+    detail::run_tasks(threads, [&](size_t t) {
+      auto& next = counts[t];
+      const auto stop = detail::slice_start(size, threads, t + 1);
+      for (auto i = detail::slice_start(size, threads, t); i < stop; i++) {
+        to[next[digit(from[i])]++] = from[i];
+      }
+    });
+    std::swap(from, to);
+  }
+  if (from != data) std::copy(from, from + size, data);
+}
+
+template <typename T>
+void radix_sort(std::vector<T>& values, size_t threads = std::thread::hardware_concurrency()) {
+  radix_sort(values.data(), values.size(), threads);
+}
+
+// Sorts [first, last) by comp, not stably.
+template <typename RandomIt, typename Compare = std::less<>>
+void sample_sort(RandomIt first, RandomIt last, Compare comp = {},
+                 size_t threads = std::thread::hardware_concurrency()) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  const auto size = static_cast<size_t>(last - first);
+  threads = detail::thread_count(size, threads);
+  if (threads == 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  // Evenly spaced samples; oversampling evens out the bucket sizes.
+  const size_t buckets = threads, oversampling = 64;
+  std::vector<T> sample;
+  const auto samples = buckets * oversampling;
+  for (size_t i{}; i < samples; i++) sample.push_back(first[size * i / samples + size / samples / 2]);
+  std::sort(sample.begin(), sample.end(), comp);
+  std::vector<T> splitters;
+  for (size_t b{ 1 }; b < buckets; b++) splitters.push_back(sample[b * oversampling]);
+
+  // Each thread finds the buckets of its slice and counts them.
+  std::vector<uint32_t> bucket_of(size);
+  std::vector<std::vector<size_t>> counts(threads, std::vector<size_t>(buckets));
+  detail::run_tasks(threads, [&](size_t t) {
+    const auto stop = detail::slice_start(size, threads, t + 1);
+    for (auto i = detail::slice_start(size, threads, t); i < stop; i++) {
+      const auto b = std::upper_bound(splitters.begin(), splitters.end(), first[i], comp) -
+                     splitters.begin();
+      bucket_of[i] = static_cast<uint32_t>(b);
+      counts[t][b]++;
+    }
+  });
+  std::vector<size_t> bucket_starts(buckets + 1);
+  size_t offset{};
+  for (size_t b{}; b < buckets; b++) {
+    bucket_starts[b] = offset;
+    for (size_t t{}; t < threads; t++) {
+      const auto count = counts[t][b];
+      counts[t][b] = offset;
+      offset += count;
+    }
+  }
+  bucket_starts[buckets] = size;
+
+  std::vector<T> buffer(size);
+  detail::run_tasks(threads, [&](size_t t) {
+    auto& next = counts[t];
+    const auto stop = detail::slice_start(size, threads, t + 1);
+    for (auto i = detail::slice_start(size, threads, t); i < stop; i++) {
+      buffer[next[bucket_of[i]]++] = std::move(first[i]);
+    }
+  });
+  detail::run_tasks(buckets, [&](size_t b) {
+    const auto begin = buffer.begin() + bucket_starts[b];
+    const auto end = buffer.begin() + bucket_starts[b + 1];
+    std::sort(begin, end, comp);
+    std::move(begin, end, first + bucket_starts[b]);
+  });
+}
+
+// Sorts [first, last) by comp, keeping equal elements in their order.
+template <typename RandomIt, typename Compare = std::less<>>
+void stable_sort(RandomIt first, RandomIt last, Compare comp = {},
+                 size_t threads = std::thread::hardware_concurrency()) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  const auto size = static_cast<size_t>(last - first);
+  threads = detail::thread_count(size, threads);
+  if (threads == 1) {
+    std::stable_sort(first, last, comp);
+    return;
+  }
+
+  std::vector<size_t> runs;  // Run r is [runs[r], runs[r + 1]).
+  for (size_t t{}; t <= threads; t++) runs.push_back(detail::slice_start(size, threads, t));
+  detail::run_tasks(threads, [&](size_t t) {
+    std::stable_sort(first + runs[t], first + runs[t + 1], comp);
+  });
+
+  // Each round merges pairs of runs from one side into the other. Merging
+  // takes from the left run on ties, so the result stays stable. Thread t
+  // writes slice t of the output: where it falls in a pair's merge is found
+  // by the merge path, so a slice may cover the end of a pair and the start
+  // of the next one.
+  std::vector<T> buffer(size);
+  bool in_buffer{};
+  while (runs.size() > 2) {
+    const auto merge_runs = [&](auto from, auto to) {
+      detail::run_tasks(threads, [&](size_t t) {
+        const auto slice_begin = detail::slice_start(size, threads, t);
+        const auto slice_end = detail::slice_start(size, threads, t + 1);
+        // The pair that slice_begin falls in: pairs start at even runs.
+        auto p = static_cast<size_t>(std::upper_bound(runs.begin(), runs.end() - 1, slice_begin) -
+                                     runs.begin() - 1) / 2;
+        for (; 2 * p < runs.size() - 1 && runs[2 * p] < slice_end; p++) {
+          const auto begin = runs[2 * p];
+          const auto middle = runs[2 * p + 1];
+          const auto end = 2 * p + 2 < runs.size() ? runs[2 * p + 2] : size;
+          const auto out_begin = std::max(begin, slice_begin) - begin;
+          const auto out_end = std::min(end, slice_end) - begin;
+          const auto left = from + begin, right = from + middle;
+          const auto size_left = middle - begin, size_right = end - middle;
+          const auto from_left =
+            Parallel::detail::merge_path(left, size_left, right, size_right, out_begin, comp);
+          const auto to_left = Parallel::detail::merge_path(left, size_left, right, size_right, out_end, comp);
+          std::merge(std::make_move_iterator(left + from_left), std::make_move_iterator(left + to_left),
+                     std::make_move_iterator(right + (out_begin - from_left)),
+                     std::make_move_iterator(right + (out_end - to_left)), to + begin + out_begin, comp);
+        }
+      });
+    };
+    if (in_buffer) {
+      merge_runs(buffer.begin(), first);
+    } else {
+      merge_runs(first, buffer.begin());
+    }
+    in_buffer = !in_buffer;
+    std::vector<size_t> merged;
+    for (size_t r{}; r < runs.size(); r += 2) merged.push_back(runs[r]);
+    if (merged.back() != size) merged.push_back(size);
+    runs = std::move(merged);
+  }
+  if (in_buffer) {
+    detail::run_tasks(threads, [&](size_t t) {
+      const auto begin = detail::slice_start(size, threads, t), end = detail::slice_start(size, threads, t + 1);
+      std::move(buffer.begin() + begin, buffer.begin() + end, first + begin);
+    });
+  }
+}
+
+}
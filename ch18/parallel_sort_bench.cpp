@@ -0,0 +1,43 @@
+// std::sort against the sorts of parallel_sort.h, on random 32-bit keys.
+// Build with `make parallel_sort_bench` (optimized, see Makefile). Sizes go
+// from 10^6 up to 10^8, or 10^N with `./parallel_sort_bench N`; 10^9 keys need
+// about 12 GB of memory.
+
+#include "parallel_sort.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+template <typename Fn>
+double ms_to_sort(const std::vector<uint32_t>& keys, Fn sort) {
+  auto copy = keys;
+  const auto start = std::chrono::steady_clock::now();
+  sort(copy);
+  const auto stop = std::chrono::steady_clock::now();
+  if (!std::is_sorted(copy.begin(), copy.end())) {
+    printf("not sorted!\n");
+    std::exit(1);
+  }
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char** argv) {
+  const auto max_exponent = argc > 1 ? std::atoi(argv[1]) : 8;
+  printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  printf("%12s %12s %12s %12s %12s %12s\n", "keys", "std::sort", "radix", "sample",
+         "std::stable", "stable");
+  size_t size{ 1'000'000 };
+  for (int exponent{ 6 }; exponent <= max_exponent; exponent++, size *= 10) {
+    std::vector<uint32_t> keys(size);
+    std::mt19937 engine{ 42 };
+    for (auto& key : keys) key = engine();
+    printf("%12zu", size);
+    printf(" %10.1fms", ms_to_sort(keys, [](auto& v) { std::sort(v.begin(), v.end()); }));
+    printf(" %10.1fms", ms_to_sort(keys, [](auto& v) { ParallelSort::radix_sort(v); }));
+    printf(" %10.1fms", ms_to_sort(keys, [](auto& v) { ParallelSort::sample_sort(v.begin(), v.end()); }));
+    printf(" %10.1fms", ms_to_sort(keys, [](auto& v) { std::stable_sort(v.begin(), v.end()); }));
+    printf(" %10.1fms\n", ms_to_sort(keys, [](auto& v) { ParallelSort::stable_sort(v.begin(), v.end()); }));
+  }
+}
@@ -0,0 +1,285 @@
+// ---------------------------------------------------------------------------------
+// Searchers for std::search(first, last, searcher): Boyer-Moore-Horspool with
+// an AVX2 skip loop, Crochemore-Perrin two-way, and Searcher, which picks one
+// by the needle's length.
+//
+// std::default_searcher tries every position of the haystack and compares
+// the needle there: O(n m) at worst.
+// * HorspoolSearcher looks at the last byte of the window: unless the window
+//   matches, the needle moves until its last occurrence of that byte is under
+//   it, which skips up to m positions at once. It's for 1-byte elements. With
+//   AVX2 the skipping is vectorized instead: 32 windows at a time are checked
+//   for the needle's first and last bytes, and the whole needle is only
+//   compared at windows where both match, which on real text is rare.
+// * TwoWaySearcher splits the needle at a "critical factorization" computed
+//   from its maximal suffixes, matches the right part left to right and then
+//   the left part, and shifts by what the needle's period allows. It's linear
+//   in the worst case, with constant extra space, for any elements with < and
+//   ==, and it's what glibc's memmem uses for long needles.
+// * Searcher uses memchr for a single byte, HorspoolSearcher for needles of
+//   up to Searcher::horspool_max bytes, and TwoWaySearcher beyond, where
+//   Horspool's worst case costs most; for other element types, two-way.
+// searchers_bench.cpp compares them with std's on text and random bytes.
+//
+// Like std's searchers, operator() returns the range of the first match, or
+// {last, last}. The searchers keep a copy of the needle.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <immintrin.h>
+
+#include "parallel_algorithms.h"
+
+namespace Searchers {
+
+namespace detail {
+
+template <typename T>
+constexpr bool is_byte_v = sizeof(T) == 1 && (std::is_integral_v<T> || std::is_same_v<T, std::byte>);
+
+// Parallel's contiguous iterators, and std::string's.
+template <typename It>
+constexpr bool is_contiguous_v = Parallel::detail::is_contiguous_v<It> ||
+                                 std::is_same_v<It, std::string::iterator> ||
+                                 std::is_same_v<It, std::string::const_iterator>;
+
+template <typename It>
+auto bytes(It it) {
+  return reinterpret_cast<const unsigned char*>(&*it);
+}
+
+// The first of the windows [0, size - m] of haystack where needle is, with
+// the AVX2 skip loop, or size if there is none. Stops where fewer than 32
+// windows are left; those are for the caller, from done.
+__attribute__((target("avx2")))
+inline size_t find_avx2(const unsigned char* haystack, size_t size, const unsigned char* needle, size_t m,
+                        size_t& done) {
+  const auto first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+  const auto last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+  size_t position{};
+  for (; position + m - 1 + 32 <= size; position += 32) {
+    const auto starts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + position));
+    const auto ends = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + position + m - 1));
+    auto candidates = static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(starts, first), _mm256_cmpeq_epi8(ends, last))));
+    for (; candidates; candidates &= candidates - 1) {
+      const auto window = position + __builtin_ctz(candidates);
+      if (m <= 2 || std::memcmp(haystack + window + 1, needle + 1, m - 2) == 0) return window;
+    }
+  }
+  done = position;
+  return size;
+}
+
+}
+
+template <typename It>
+class HorspoolSearcher {
+public:
+  using T = typename std::iterator_traits<It>::value_type;
+  static_assert(detail::is_byte_v<T>, "HorspoolSearcher is for 1-byte elements");
+
+  HorspoolSearcher(It first, It last) : needle_(first, last) {
+    const auto m = needle_.size();
+    shifts_.fill(m);
+    // The distance from the last occurrence of each byte to the needle's end,
+    // not counting the last byte itself.
+    for (size_t i{}; i + 1 < m; i++) shifts_[byte(needle_[i])] = m - 1 - i;
+  }
+
+  template <typename It2>
+  std::pair<It2, It2> operator()(It2 first, It2 last) const {
+    const auto m = needle_.size();
+    const size_t size = last - first;
+    if (m == 0) return { first, first };
+    if (m > size) return { last, last };
+    size_t position{};
+    using T2 = typename std::iterator_traits<It2>::value_type;
+    if constexpr (detail::is_contiguous_v<It2> && std::is_same_v<T2, T>) {
+      if (__builtin_cpu_supports("avx2")) {
+        const auto found =
+          detail::find_avx2(detail::bytes(first), size, detail::bytes(needle_.begin()), m, position);
+        if (found != size) return { first + found, first + found + m };
+      }
+    }
+    while (position + m <= size) {
+      const auto end = first[position + m - 1];
+      if (end == needle_[m - 1] && std::equal(needle_.begin(), needle_.end() - 1, first + position)) {
+        return { first + position, first + position + m };
+      }
+      position += shifts_[byte(end)];
+    }
+    return { last, last };
+  }
+
+private:
+  static unsigned char byte(T value) { return static_cast<unsigned char>(value); }
+
+  std::vector<T> needle_;
+  std::array<size_t, 256> shifts_;
+};
+
+template <typename It>
+class TwoWaySearcher {
+public:
+  using T = typename std::iterator_traits<It>::value_type;
+
+  TwoWaySearcher(It first, It last) : needle_(first, last) {
+    // The critical factorization is at the later of the maximal suffixes for
+    // < and for >; the period of that suffix bounds the needle's.
+    ptrdiff_t period, reverse_period;
+    const auto suffix = maximal_suffix(false, period), reverse_suffix = maximal_suffix(true, reverse_period);
+    suffix_ = std::max(suffix, reverse_suffix) + 1;
+    period_ = suffix > reverse_suffix ? period : reverse_period;
+    const auto m = static_cast<ptrdiff_t>(needle_.size());
+    // Whether the needle is periodic: its left part repeats period_ later.
+    periodic_ = suffix_ + period_ <= m &&
+                std::equal(needle_.begin(), needle_.begin() + suffix_, needle_.begin() + period_);
+    if (!periodic_) period_ = std::max(suffix_, m - suffix_) + 1;
+    if constexpr (detail::is_byte_v<T>) {
+      // As HorspoolSearcher's, but 0 for the needle's last byte.
+      shifts_.fill(m);
+      for (ptrdiff_t i{}; i < m; i++) shifts_[static_cast<unsigned char>(needle_[i])] = m - 1 - i;
+    }
+  }
+
+  template <typename It2>
+  std::pair<It2, It2> operator()(It2 first, It2 last) const {
+    const auto m = static_cast<ptrdiff_t>(needle_.size());
+    const auto n = static_cast<ptrdiff_t>(last - first);
+    if (m == 0) return { first, first };
+    // For a periodic needle, how much of its start the last shift kept
+    // matched, so it isn't compared again.
+    ptrdiff_t memory{};
+    for (ptrdiff_t j{}; j <= n - m;) {
+      // Bytes first skip as in Horspool, unless the window's last byte
+      // matches; a skip undoes the memory of a period, though.
+      if constexpr (detail::is_byte_v<T>) {
+        auto shift = shifts_[static_cast<unsigned char>(first[j + m - 1])];
+        if (shift > 0) {
+          if (periodic_ && memory && shift < period_) shift = m - period_;
+          memory = 0;
+          j += shift;
+          continue;
+        }
+      }
+      // The right part, left to right.
+      auto i = std::max(suffix_, memory);
+      while (i < m && needle_[i] == first[i + j]) i++;
+      if (i < m) {
+        j += i - suffix_ + 1;
+        memory = 0;
+        continue;
+      }
+      // Then the left part, right to left.
+      i = suffix_ - 1;
+      while (i >= memory && needle_[i] == first[i + j]) i--;
+      if (i < memory) return { first + j, first + j + m };
+      j += period_;
+      if (periodic_) memory = m - period_;
+    }
+    return { last, last };
+  }
+
+private:
+  // The start of the needle's lexicographically maximal suffix, for < or,
+  // reversed, for >, minus one; its period goes to period.
+  ptrdiff_t maximal_suffix(bool reversed, ptrdiff_t& period) const {
+    const auto m = static_cast<ptrdiff_t>(needle_.size());
+    ptrdiff_t suffix{ -1 }, j{}, k{ 1 };
+    period = 1;
+    while (j + k < m) {
+      const auto& a = needle_[j + k];
+      const auto& b = needle_[suffix + k];
+      if (reversed ? b < a : a < b) {
+        j += k;
+        k = 1;
+        period = j - suffix;
+      } else if (a == b) {
+        if (k != period) {
+          k++;
+        } else {
+          j += period;
+          k = 1;
+        }
+      } else {
+        suffix = j;
+        j = suffix + 1;
+        k = period = 1;
+      }
+    }
+    return suffix;
+  }
+
+  std::vector<T> needle_;
+  // The right part of the factorization starts at suffix_.
+  ptrdiff_t suffix_, period_;
+  bool periodic_;
+  std::array<ptrdiff_t, 256> shifts_;
+};
+
+// HorspoolSearcher or TwoWaySearcher, by the needle's length.
+template <typename It>
+class Searcher {
+public:
+  using T = typename std::iterator_traits<It>::value_type;
+  static constexpr size_t horspool_max = 64;
+
+  Searcher(It first, It last) : searcher_{ make(first, last) } {}
+
+  template <typename It2>
+  std::pair<It2, It2> operator()(It2 first, It2 last) const {
+    return std::visit([&](const auto& searcher) { return search(searcher, first, last); }, searcher_);
+  }
+
+private:
+  struct Single {
+    T value;
+  };
+
+  using Horspool = std::conditional_t<detail::is_byte_v<T>, HorspoolSearcher<It>, Single>;
+  using Variant = std::variant<Single, Horspool, TwoWaySearcher<It>>;
+
+  static Variant make(It first, It last) {
+    const auto m = static_cast<size_t>(std::distance(first, last));
+    if constexpr (detail::is_byte_v<T>) {
+      if (m == 1) return Single{ *first };
+      if (m <= horspool_max) return Variant{ std::in_place_index<1>, first, last };
+    }
+    return TwoWaySearcher<It>{ first, last };
+  }
+
+  template <typename Fallback, typename It2>
+  static std::pair<It2, It2> search(const Fallback& searcher, It2 first, It2 last) {
+    return searcher(first, last);
+  }
+
+  template <typename It2>
+  static std::pair<It2, It2> search(const Single& single, It2 first, It2 last) {
+    if constexpr (detail::is_contiguous_v<It2> && detail::is_byte_v<T>) {
+      if (first == last) return { last, last };
+      const auto found = static_cast<const unsigned char*>(
+        std::memchr(detail::bytes(first), static_cast<unsigned char>(single.value), last - first));
+      if (!found) return { last, last };
+      const auto at = first + (found - detail::bytes(first));
+      return { at, at + 1 };
+    } else {
+      const auto at = std::find(first, last, single.value);
+      return { at, at == last ? last : std::next(at) };
+    }
+  }
+
+  Variant searcher_;
+};
+
+}
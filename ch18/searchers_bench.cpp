@@ -0,0 +1,61 @@
+// std's searchers against those of searchers.h, on 64 MB of text made of
+// random words and 64 MB of random bytes, in GB/s of haystack. Each needle is
+// a piece of the haystack ending with a byte found nowhere else, and is put
+// at the haystack's end, so every search goes through all of it.
+// Build with `make searchers_bench` (optimized, see Makefile).
+
+#include "searchers.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+
+constexpr size_t haystack_size{ 64 << 20 };
+
+template <typename Searcher>
+double gb_per_s(const std::string& haystack, const std::string& needle, const Searcher& searcher) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto found = std::search(haystack.begin(), haystack.end(), searcher);
+  const auto stop = std::chrono::steady_clock::now();
+  if (found != std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end())) {
+    printf("wrong match!\n");
+    std::exit(1);
+  }
+  return (found - haystack.begin()) / std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+void bench(const char* name, const std::string& source, char sentinel) {
+  printf("%s\n%8s %10s %10s %10s %10s %10s\n", name, "needle", "default", "std bmh", "horspool", "two-way",
+         "searcher");
+  for (size_t length : { 1, 4, 8, 16, 32, 64, 256, 1024 }) {
+    const auto needle = source.substr(source.size() / 2, length - 1) + sentinel;
+    auto haystack = source;
+    haystack.replace(haystack.size() - length, length, needle);
+    using It = std::string::const_iterator;
+    printf("%8zu", length);
+    printf(" %8.2fGB", gb_per_s(haystack, needle, std::default_searcher{ needle.begin(), needle.end() }));
+    printf(" %8.2fGB",
+           gb_per_s(haystack, needle, std::boyer_moore_horspool_searcher{ needle.begin(), needle.end() }));
+    printf(" %8.2fGB", gb_per_s(haystack, needle, Searchers::HorspoolSearcher<It>{ needle.begin(), needle.end() }));
+    printf(" %8.2fGB", gb_per_s(haystack, needle, Searchers::TwoWaySearcher<It>{ needle.begin(), needle.end() }));
+    printf(" %8.2fGB\n", gb_per_s(haystack, needle, Searchers::Searcher<It>{ needle.begin(), needle.end() }));
+  }
+}
+
+int main() {
+  std::mt19937 engine{ 42 };
+  const char* words[]{ "the", "of", "and", "a", "to", "in", "is", "you", "that", "it", "he", "was", "for", "on",
+                       "are", "as", "with", "his", "they", "at", "be", "this", "have", "from", "or", "one",
+                       "had", "by", "word", "but", "not", "what", "all", "were", "we", "when", "your", "can",
+                       "said", "there", "use", "an", "each", "which", "she", "do", "how", "their", "if" };
+  std::string text;
+  while (text.size() < haystack_size) {
+    text += words[engine() % std::size(words)];
+    text += engine() % 12 ? " " : ".\n";
+  }
+  bench("text", text, '#');
+  std::string binary(haystack_size, '\0');
+  for (auto& byte : binary) byte = static_cast<char>(engine() % 255);
+  bench("random bytes", binary, static_cast<char>(255));
+}
@@ -0,0 +1,278 @@
+// ---------------------------------------------------------------------------------
+// Set operations on sorted sets of integers: set_intersection, set_union,
+// set_difference, and intersect_all for any number of sets.
+//
+// These are the operations of an inverted index, whose posting lists are
+// sorted document numbers. A merge compares one pair of elements per step and
+// branches on the result, which mispredicts about half the time when the
+// lists interleave. Two better strategies, by how the sizes compare:
+// * Similar sizes: with AVX2, a block of 8 elements of one list (4 for 64-bit
+//   ones) is compared with a block of the other for equality in all 64 pairs
+//   at once, by comparing it with every rotation of the other block. That
+//   gives which elements of the first block are in the second; the block
+//   whose last element is smaller is then done and the next one is loaded.
+//   Intersection and difference are the members and non-members of the
+//   first list.
+// * Skewed sizes: every element of the short list is searched in the long
+//   one, galloping from the last position found: steps of 1, 2, 4... until
+//   one passes it, then a binary search in the last step. That's
+//   O(n log(m / n)) rather than O(n + m), and a difference or union copies the
+//   runs of the long list between two hits whole.
+// The unions of similar sizes are merged without branches.
+//
+// The sets are sorted and without duplicates. For other element types or
+// non-contiguous ranges, the algorithms call std's, which also handle
+// duplicates.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <immintrin.h>
+
+#include "parallel_algorithms.h"
+
+namespace SortedSets {
+
+namespace detail {
+
+// Beyond this ratio of sizes, galloping through the long list beats going
+// through every element of it.
+constexpr size_t gallop_ratio = 32;
+
+template <typename It1, typename It2>
+constexpr bool is_fast_v = []() {
+  using T = typename std::iterator_traits<It1>::value_type;
+  return std::is_same_v<T, typename std::iterator_traits<It2>::value_type> && std::is_integral_v<T> &&
+         (sizeof(T) == 4 || sizeof(T) == 8) && Parallel::detail::is_contiguous_v<It1> &&
+         Parallel::detail::is_contiguous_v<It2>;
+}();
+
+template <typename It>
+auto data(It first, It last) {
+  return first == last ? nullptr : &*first;
+}
+
+// The first position in [from, size) of p whose element isn't less than
+// value, or size.
+template <typename T>
+size_t gallop(const T* p, size_t from, size_t size, T value) {
+  if (from >= size || !(p[from] < value)) return from;
+  // p[low] < value throughout.
+  size_t low{ from }, step{ 1 };
+  while (low + step < size && p[low + step] < value) {
+    low += step;
+    step *= 2;
+  }
+  return std::lower_bound(p + low + 1, p + std::min(low + step, size), value) - p;
+}
+
+// Lane-wise equality of a block of a with every lane of a block of b, for 4
+// and 8-byte elements: bit k of the result is set if a's lane k is in b.
+template <size_t bytes>
+struct Blocks;
+
+template <>
+struct Blocks<4> {
+  static constexpr size_t count = 8;
+  __attribute__((target("avx2"))) static unsigned members(const void* a, const void* b) {
+    const auto as = _mm256_loadu_si256(static_cast<const __m256i*>(a));
+    auto bs = _mm256_loadu_si256(static_cast<const __m256i*>(b));
+    const auto rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    auto equal = _mm256_cmpeq_epi32(as, bs);
+    for (int r{ 1 }; r < 8; r++) {
+      bs = _mm256_permutevar8x32_epi32(bs, rotate);
+      equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(as, bs));
+    }
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+  }
+};
+
+template <>
+struct Blocks<8> {
+  static constexpr size_t count = 4;
+  __attribute__((target("avx2"))) static unsigned members(const void* a, const void* b) {
+    const auto as = _mm256_loadu_si256(static_cast<const __m256i*>(a));
+    auto bs = _mm256_loadu_si256(static_cast<const __m256i*>(b));
+    auto equal = _mm256_cmpeq_epi64(as, bs);
+    for (int r{ 1 }; r < 4; r++) {
+      bs = _mm256_permute4x64_epi64(bs, 0x39);
+      equal = _mm256_or_si256(equal, _mm256_cmpeq_epi64(as, bs));
+    }
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(equal)));
+  }
+};
+
+// Writes the elements of a[i, size_a) that are in b[j, size_b), or with
+// members false those that aren't, one pair at a time.
+template <bool members, typename T, typename OutIt>
+OutIt filter_merge(const T* a, size_t i, size_t size_a, const T* b, size_t j, size_t size_b, OutIt out) {
+  while (i < size_a && j < size_b) {
+    if (a[i] < b[j]) {
+      if (!members) *out++ = a[i];
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      if (members) *out++ = a[i];
+      i++;
+      j++;
+    }
+  }
+  if (!members) out = std::copy(a + i, a + size_a, out);
+  return out;
+}
+
+template <bool members, typename T, typename OutIt>
+__attribute__((target("avx2")))
+OutIt filter_avx2(const T* a, size_t size_a, const T* b, size_t size_b, OutIt out) {
+  using B = Blocks<sizeof(T)>;
+  constexpr size_t lanes = B::count;
+  constexpr unsigned all = (1u << lanes) - 1;
+  size_t i{}, j{};
+  // Which elements of a's current block were in the blocks of b so far.
+  unsigned found{};
+  while (i + lanes <= size_a && j + lanes <= size_b) {
+    found |= B::members(a + i, b + j);
+    const auto last_a = a[i + lanes - 1], last_b = b[j + lanes - 1];
+    if (last_a <= last_b) {
+      for (auto bits = members ? found : ~found & all; bits; bits &= bits - 1) {
+        *out++ = a[i + __builtin_ctz(bits)];
+      }
+      found = 0;
+      i += lanes;
+    }
+    if (last_b <= last_a) j += lanes;
+  }
+  // The rest of a's current block against the rest of b, then the others.
+  const auto block_end = std::min(i + lanes, size_a);
+  for (size_t lane{}; i < block_end; i++, lane++) {
+    while (j < size_b && b[j] < a[i]) j++;
+    if (((found >> lane & 1) || (j < size_b && b[j] == a[i])) == members) *out++ = a[i];
+  }
+  return filter_merge<members>(a, i, size_a, b, j, size_b, out);
+}
+
+// The same for an a much shorter than b: each element of a is galloped to.
+template <bool members, typename T, typename OutIt>
+OutIt filter_gallop(const T* a, size_t size_a, const T* b, size_t size_b, OutIt out) {
+  size_t j{};
+  for (size_t i{}; i < size_a; i++) {
+    j = gallop(b, j, size_b, a[i]);
+    if ((j < size_b && b[j] == a[i]) == members) *out++ = a[i];
+  }
+  return out;
+}
+
+template <bool members, typename T, typename OutIt>
+OutIt filter(const T* a, size_t size_a, const T* b, size_t size_b, OutIt out) {
+  if (size_b / gallop_ratio >= size_a) return filter_gallop<members>(a, size_a, b, size_b, out);
+  if (__builtin_cpu_supports("avx2")) return filter_avx2<members>(a, size_a, b, size_b, out);
+  return filter_merge<members>(a, 0, size_a, b, 0, size_b, out);
+}
+
+// Copies long, skipping the elements of the much shorter skip, or with merge
+// true, merging them in; copies the runs between them whole.
+template <bool merge, typename T, typename OutIt>
+OutIt copy_gallop(const T* long_set, size_t long_size, const T* skip, size_t skip_size, OutIt out) {
+  size_t i{};
+  for (size_t j{}; j < skip_size; j++) {
+    const auto next = gallop(long_set, i, long_size, skip[j]);
+    out = std::copy(long_set + i, long_set + next, out);
+    i = next;
+    if (i < long_size && long_set[i] == skip[j]) {
+      if (merge) *out++ = long_set[i];
+      i++;
+    } else if (merge) {
+      *out++ = skip[j];
+    }
+  }
+  return std::copy(long_set + i, long_set + long_size, out);
+}
+
+template <typename T, typename OutIt>
+OutIt merge_union(const T* a, size_t size_a, const T* b, size_t size_b, OutIt out) {
+  size_t i{}, j{};
+  while (i < size_a && j < size_b) {
+    const auto x = a[i], y = b[j];
+    *out++ = y < x ? y : x;
+    i += !(y < x);
+    j += !(x < y);
+  }
+  out = std::copy(a + i, a + size_a, out);
+  return std::copy(b + j, b + size_b, out);
+}
+
+}
+
+template <typename It1, typename It2, typename OutIt>
+OutIt set_intersection(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first) {
+  if constexpr (detail::is_fast_v<It1, It2>) {
+    const auto a = detail::data(first1, last1), b = detail::data(first2, last2);
+    const size_t size_a = last1 - first1, size_b = last2 - first2;
+    // The shorter one is filtered.
+    return size_a <= size_b ? detail::filter<true>(a, size_a, b, size_b, d_first)
+                            : detail::filter<true>(b, size_b, a, size_a, d_first);
+  } else {
+    return std::set_intersection(first1, last1, first2, last2, d_first);
+  }
+}
+
+// The elements of the first set that aren't in the second.
+template <typename It1, typename It2, typename OutIt>
+OutIt set_difference(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first) {
+  if constexpr (detail::is_fast_v<It1, It2>) {
+    const auto a = detail::data(first1, last1), b = detail::data(first2, last2);
+    const size_t size_a = last1 - first1, size_b = last2 - first2;
+    if (size_a / detail::gallop_ratio >= size_b) {
+      return detail::copy_gallop<false>(a, size_a, b, size_b, d_first);
+    }
+    return detail::filter<false>(a, size_a, b, size_b, d_first);
+  } else {
+    return std::set_difference(first1, last1, first2, last2, d_first);
+  }
+}
+
+template <typename It1, typename It2, typename OutIt>
+OutIt set_union(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first) {
+  if constexpr (detail::is_fast_v<It1, It2>) {
+    const auto a = detail::data(first1, last1), b = detail::data(first2, last2);
+    const size_t size_a = last1 - first1, size_b = last2 - first2;
+    if (size_a / detail::gallop_ratio >= size_b) {
+      return detail::copy_gallop<true>(a, size_a, b, size_b, d_first);
+    }
+    if (size_b / detail::gallop_ratio >= size_a) {
+      return detail::copy_gallop<true>(b, size_b, a, size_a, d_first);
+    }
+    return detail::merge_union(a, size_a, b, size_b, d_first);
+  } else {
+    return std::set_union(first1, last1, first2, last2, d_first);
+  }
+}
+
+// The intersection of all of sets, e.g. a vector of vectors. The two shortest
+// are intersected first, and the result, shorter still, with each longer set
+// in turn, which gallops once the result is short enough.
+template <typename Sets>
+auto intersect_all(const Sets& sets) {
+  using Set = typename Sets::value_type;
+  std::vector<typename Set::value_type> result, next;
+  std::vector<const Set*> order;
+  for (const auto& set : sets) order.push_back(&set);
+  if (order.empty()) return result;
+  std::sort(order.begin(), order.end(), [](const Set* a, const Set* b) { return a->size() < b->size(); });
+  result.assign(order[0]->begin(), order[0]->end());
+  for (size_t k{ 1 }; k < order.size() && !result.empty(); k++) {
+    next.resize(result.size());
+    next.erase(SortedSets::set_intersection(result.begin(), result.end(), order[k]->begin(), order[k]->end(),
+                                            next.begin()),
+               next.end());
+    result.swap(next);
+  }
+  return result;
+}
+
+}
@@ -0,0 +1,94 @@
+// ---------------------------------------------------------------------------------
+// Parallel partitioning and removal: stream compaction.
+//
+// Keeping the elements of a sequence that match a predicate, in order, is
+// stream compaction. Its parallel form is the Selection of
+// parallel_algorithms.h: a bitmask of the predicate and a count of matches per
+// block, whose running sums give every block its place in the output, then
+// a left-packing copy of each block in parallel.
+//
+// The algorithms below are all stable, including partition, which std leaves
+// unstable: elements keep their order on both sides. The in-place ones
+// compact into a buffer and move the result back, so they need
+// default-constructible elements, like std::stable_partition's buffer.
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "parallel_algorithms.h"
+
+namespace Parallel {
+
+// Copies the elements matching pred to d_true and the others to d_false, both
+// in order, and returns the ends of the two outputs.
+template <typename It, typename OutIt1, typename OutIt2, typename Predicate>
+std::pair<OutIt1, OutIt2> partition_copy(const ExecutionPolicy& policy, It first, It last,
+                                         OutIt1 d_true, OutIt2 d_false, Predicate pred) {
+  const auto size = detail::range_size(first, last);
+  const detail::Selection selection{ policy, first, size, pred };
+  selection.copy_selected(first, d_true);
+  selection.copy_selected(first, d_false, false);
+  return { d_true + selection.selected(), d_false + (size - selection.selected()) };
+}
+
+namespace detail {
+
+// first, or a move iterator if the elements are worth moving.
+template <typename It>
+auto move_if_costly(It first) {
+  if constexpr (LeftPack::detail::is_packable_v<typename std::iterator_traits<It>::value_type>) {
+    return first;
+  } else {
+    return std::make_move_iterator(first);
+  }
+}
+
+template <typename T, typename It>
+void move_back(const ExecutionPolicy& policy, std::vector<T>& buffer, It first) {
+  Parallel::transform(policy, buffer.begin(), buffer.end(), first, [](T& value) { return std::move(value); });
+}
+
+}
+
+// Moves the elements matching pred before the others, keeping the order on
+// both sides, and returns the first of the others.
+template <typename It, typename Predicate>
+It stable_partition(const ExecutionPolicy& policy, It first, It last, Predicate pred) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const auto size = detail::range_size(first, last);
+  const detail::Selection selection{ policy, first, size, pred };
+  std::vector<T> buffer(size);
+  selection.copy_selected(detail::move_if_costly(first), buffer.begin());
+  selection.copy_selected(detail::move_if_costly(first), buffer.begin() + selection.selected(), false);
+  detail::move_back(policy, buffer, first);
+  return first + selection.selected();
+}
+
+template <typename It, typename Predicate>
+It partition(const ExecutionPolicy& policy, It first, It last, Predicate pred) {
+  return Parallel::stable_partition(policy, first, last, pred);
+}
+
+// Removes the elements matching pred, keeping the order of the others, and
+// returns the new end of the range.
+template <typename It, typename Predicate>
+It remove_if(const ExecutionPolicy& policy, It first, It last, Predicate pred) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const auto size = detail::range_size(first, last);
+  const detail::Selection selection{ policy, first, size, pred };
+  std::vector<T> kept(size - selection.selected());
+  selection.copy_selected(detail::move_if_costly(first), kept.begin(), false);
+  detail::move_back(policy, kept, first);
+  return first + kept.size();
+}
+
+template <typename It, typename T>
+It remove(const ExecutionPolicy& policy, It first, It last, const T& value) {
+  return Parallel::remove_if(policy, first, last, [&value](const auto& element) { return element == value; });
+}
+
+}
@@ -0,0 +1,161 @@
+// ---------------------------------------------------------------------------------
+// ThreadPool: a fixed set of worker threads with work stealing.
+//
+// Starting std::threads for every parallel call costs tens of microseconds
+// each. The pool starts its workers once, and each keeps its own deque of
+// tasks: a worker takes its newest task first, which is the one whose data is
+// most likely still in cache, and when its deque is empty it steals the oldest
+// task of another worker, which is usually the largest piece of work left.
+//
+// run(tasks, fn) is a fork-join: it queues fn(0) ... fn(tasks - 1) and, while
+// waiting for them, the calling thread runs queued tasks too. So the caller is
+// one more worker, a pool without workers runs everything on the caller, and
+// tasks can call run themselves without deadlocking the pool.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+  // The calling thread of run works too, so workers is one less than the
+  // threads wanted.
+  explicit ThreadPool(size_t workers = std::max(1u, std::thread::hardware_concurrency()) - 1) {
+    for (size_t i{}; i <= workers; i++) queues.push_back(std::make_unique<Queue>());
+    for (size_t i{}; i < workers; i++) threads.emplace_back([this, i] { work(i); });
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{ sleep_mutex };
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+  }
+
+  // Threads that run tasks, counting the caller of run.
+  size_t concurrency() const { return threads.size() + 1; }
+
+  // Calls fn(i) for each i in [0, tasks) on the pool and waits for all of
+  // them. The first exception a task throws is rethrown here, once all the
+  // tasks are done.
+  template <typename Fn>
+  void run(size_t tasks, Fn fn) {
+    if (tasks == 0) return;
+    if (tasks == 1 || threads.empty()) {
+      for (size_t i{}; i < tasks; i++) fn(i);
+      return;
+    }
+    Join join{ tasks };
+    // Tasks go to the caller's own deque if it's a worker of this pool, so
+    // nested runs stay local until someone steals them.
+    const auto home = current_pool == this ? current_queue : threads.size();
+    {
+      std::lock_guard<std::mutex> lock{ queues[home]->mutex };
+      for (size_t i{}; i < tasks; i++) {
+        queues[home]->tasks.emplace_back([&join, &fn, i] {
+          try {
+            fn(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock{ join.mutex };
+            if (!join.error) join.error = std::current_exception();
+          }
+          // Under the lock, so run can't return and destroy join before
+          // this is done with it.
+          std::lock_guard<std::mutex> lock{ join.mutex };
+          if (--join.remaining == 0) join.done.notify_all();
+        });
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock{ sleep_mutex };
+      pending += tasks;
+    }
+    wake.notify_all();
+
+    while (join.remaining > 0 && run_one(home)) {}
+    std::unique_lock<std::mutex> lock{ join.mutex };
+    join.done.wait(lock, [&join] { return join.remaining == 0; });
+    if (join.error) std::rethrow_exception(join.error);
+  }
+
+  // A pool shared by everything that isn't given one.
+  static ThreadPool& shared() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  struct Join {
+    explicit Join(size_t tasks) : remaining{ tasks } {}
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+  };
+
+  // Runs the newest task of queue home, or else steals the oldest task of
+  // another queue. Returns false when every queue is empty.
+  bool run_one(size_t home) {
+    std::function<void()> task;
+    {
+      std::lock_guard<std::mutex> lock{ queues[home]->mutex };
+      if (!queues[home]->tasks.empty()) {
+        task = std::move(queues[home]->tasks.back());
+        queues[home]->tasks.pop_back();
+      }
+    }
+    for (size_t k{ 1 }; !task && k < queues.size(); k++) {
+      auto& victim = *queues[(home + k) % queues.size()];
+      std::lock_guard<std::mutex> lock{ victim.mutex };
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+      }
+    }
+    if (!task) return false;
+    pending--;
+    task();
+    return true;
+  }
+
+  void work(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    for (;;) {
+      if (run_one(index)) continue;
+      std::unique_lock<std::mutex> lock{ sleep_mutex };
+      wake.wait(lock, [this] { return stopping || pending > 0; });
+      if (stopping) return;
+    }
+  }
+
+  // The last queue is for callers that aren't workers.
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> pending{};  // Tasks queued and not yet taken.
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  bool stopping{};
+
+  static inline thread_local ThreadPool* current_pool{};
+  static inline thread_local size_t current_queue{};
+};
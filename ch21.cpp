@@ -103,10 +103,55 @@ void signals_handler() {
 
 
 #include <boost/program_options.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <vector>
+#include "ch15/aho_corasick.h"
+#include "ch15/ascii_case.h"
+
+// Lines of the file at path containing any of the matcher's patterns, as
+// "path:line number:line". To ignore case, the patterns must be folded, and
+// each line is folded into a scratch buffer before searching.
+std::string search_file(const std::filesystem::path& path, const AhoCorasick& matcher,
+                        bool ignore_case) {
+  std::ifstream file{ path };
+  std::string result, line, folded;
+  for (size_t number{ 1 }; std::getline(file, line); number++) {
+    if (ignore_case) {
+      folded.resize(line.size());
+      AsciiCase::to_lower(line, folded.data());
+    }
+    if (matcher.contains(ignore_case ? folded : line)) {
+      result.append(path.string()).append(":").append(std::to_string(number))
+            .append(":").append(line).append("\n");
+    }
+  }
+  return result;
+}
+
+std::vector<std::filesystem::path> files_in(const std::vector<std::string>& paths,
+                                            bool is_recursive) {
+  using namespace std::filesystem;
+  std::vector<path> result;
+  for (const auto& p : paths) {
+    if (!is_directory(p)) {
+      result.emplace_back(p);
+    } else if (is_recursive) {
+      for (const auto& entry : recursive_directory_iterator{ p })
+        if (entry.is_regular_file()) result.push_back(entry.path());
+    } else {
+      for (const auto& entry : directory_iterator{ p })
+        if (entry.is_regular_file()) result.push_back(entry.path());
+    }
+  }
+  return result;
+}
 
 int mgrep(int argc, char** argv) {
   using namespace boost::program_options;
-  bool is_recursive{}, is_help{};
+  bool is_recursive{}, is_help{}, ignore_case{};
 
   // Options description: specify the allowed options.
   options_description description{ "mgrep [options] pattern path1 path2 ..." };
@@ -114,6 +159,8 @@ int mgrep(int argc, char** argv) {
     ("help,h", bool_switch(&is_help), "display a help dialog")
     ("threads,t", value<int>()->default_value(4), "number of threads to use")
     ("recursive,r", bool_switch(&is_recursive), "search subdirectories recusively")
+    ("ignore-case,i", bool_switch(&ignore_case), "ignore case of ASCII letters")
+    ("file,f", value<std::string>(), "search for every line of this file at once")
     ("pattern", value<std::string>(), "pattern to search for")
     ("path", value<std::vector<std::string>>(), "path to search");
 
@@ -141,22 +188,61 @@ int mgrep(int argc, char** argv) {
     std::cout << description;
     return 0;
   }
-  if (vm["pattern"].empty()) {
+  // With a patterns file, the first positional argument is a path too.
+  std::vector<std::string> patterns, paths;
+  if (!vm["path"].empty()) paths = vm["path"].as<std::vector<std::string>>();
+  if (vm.count("file")) {
+    std::ifstream file{ vm["file"].as<std::string>() };
+    if (!file) {
+      std::cerr << "Can't read " << vm["file"].as<std::string>() << ".\n";
+      return -1;
+    }
+    for (std::string line; std::getline(file, line);)
+      if (!line.empty()) patterns.push_back(line);
+    if (!vm["pattern"].empty())
+      paths.insert(paths.begin(), vm["pattern"].as<std::string>());
+  } else if (!vm["pattern"].empty()) {
+    patterns.push_back(vm["pattern"].as<std::string>());
+  }
+  if (patterns.empty()) {
     std::cerr << "You must provide a pattern.\n";
     return -1;
   } 
-  if (vm["path"].empty()) {
+  if (paths.empty()) {
     std::cerr << "You must provide at least one path.\n";
     return -1;
   }
 
-  const auto threads = vm["threads"].as<int>();
-  const auto& pattern = vm["pattern"].as<std::string>();
-  const auto& paths = vm["path"].as<std::vector<std::string>>();
-  
-  // Implementation goes here.
+  const auto threads = std::max(vm["threads"].as<int>(), 1);
 
-  std::cout << "Ok." << std::endl;
+  // A single automaton finds all the patterns in one pass over each line,
+  // rather than one pass (or one regex) per pattern.
+  if (ignore_case) {
+    for (auto& pattern : patterns) AsciiCase::to_lower(pattern);
+  }
+  const AhoCorasick matcher{ patterns };
+  std::vector<std::filesystem::path> files;
+  try {
+    files = files_in(paths, is_recursive);
+  } catch (const std::filesystem::filesystem_error& e) {
+    std::cerr << e.what() << "\n";
+    return -1;
+  }
+
+  // Each thread searches every threads-th file; results print in file order.
+  std::vector<std::future<std::vector<std::string>>> searches;
+  for (int t{}; t < threads; t++) {
+    searches.push_back(std::async(std::launch::async, [&, t] {
+      std::vector<std::string> results;
+      for (size_t i = t; i < files.size(); i += threads)
+        results.push_back(search_file(files[i], matcher, ignore_case));
+      return results;
+    }));
+  }
+  std::vector<std::vector<std::string>> results;
+  for (auto& search : searches) results.push_back(search.get());
+  for (size_t i{}; i < files.size(); i++)
+    std::cout << results[i % threads][i / threads];
   return 0;
 }
 
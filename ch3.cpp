@@ -119,6 +119,202 @@ void trooper_traversal() {
 
 // -------------------------------------------------------------------------------- 
 
+// structure of arrays (SoA)
+// each Element above interleaves next, prefix and operating_number (an array
+// of structures, AoS), so scanning operating numbers drags every other field
+// through the cache, one pointer hop at a time. a SoA keeps each field in its
+// own contiguous array: a scan touching one field reads only that field's bytes
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <immintrin.h>
+
+// compares 8 ints at a time against [lo, hi], writing the matching indices.
+// compiled for avx2 only, so callers must check the cpu supports it
+__attribute__((target("avx2")))
+size_t filter_range_avx2(const int32_t *data, size_t n, int32_t lo, int32_t hi,
+                         uint32_t *out) {
+    const __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+    size_t count{}, i{};
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x),
+                                          _mm256_cmpgt_epi32(x, vhi));
+        unsigned bits = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xff;
+        while (bits) {
+            out[count++] = static_cast<uint32_t>(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+    for (; i < n; i++) {
+        if (lo <= data[i] && data[i] <= hi) out[count++] = static_cast<uint32_t>(i);
+    }
+    return count;
+}
+
+template <typename... Fields>
+class SoA {
+    std::tuple<std::vector<Fields>...> columns;
+
+public:
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    /*
+     * there is no struct to hand out a reference to, so dereferencing
+     * yields a proxy: the container plus an index. get<I>() reaches into
+     * column I only
+     */
+    template <bool Const>
+    class Reference {
+        using Owner = std::conditional_t<Const, const SoA, SoA>;
+        Owner *owner;
+        size_t index;
+    public:
+        Reference(Owner *owner, size_t index) : owner{ owner }, index{ index } {}
+
+        template <size_t I>
+        auto& get() const {
+            return owner->template column<I>()[index];
+        }
+
+        // copies the record out, AoS-style
+        std::tuple<Fields...> value() const {
+            return value(std::index_sequence_for<Fields...>{});
+        }
+    private:
+        template <size_t... I>
+        std::tuple<Fields...> value(std::index_sequence<I...>) const {
+            return { get<I>()... };
+        }
+    };
+
+    template <bool Const>
+    class Iterator {
+        using Owner = std::conditional_t<Const, const SoA, SoA>;
+        Owner *owner;
+        size_t index;
+    public:
+        Iterator(Owner *owner, size_t index) : owner{ owner }, index{ index } {}
+        Reference<Const> operator*() const { return { owner, index }; }
+        Iterator& operator++() { index++; return *this; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+    };
+
+    size_t size() const { return std::get<0>(columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    void reserve(size_t n) {
+        std::apply([n](auto&... column) { (column.reserve(n), ...); }, columns);
+    }
+
+    void push_back(const Fields&... fields) {
+        push_back(std::index_sequence_for<Fields...>{}, fields...);
+    }
+
+    template <size_t I>
+    std::vector<field_type<I>>& column() { return std::get<I>(columns); }
+    template <size_t I>
+    const std::vector<field_type<I>>& column() const { return std::get<I>(columns); }
+
+    Reference<false> operator[](size_t i) { return { this, i }; }
+    Reference<true> operator[](size_t i) const { return { this, i }; }
+
+    Iterator<false> begin() { return { this, 0 }; }
+    Iterator<false> end() { return { this, size() }; }
+    Iterator<true> begin() const { return { this, 0 }; }
+    Iterator<true> end() const { return { this, size() }; }
+
+    // indices whose field I lies in [lo, hi]. 32-bit integer fields are
+    // scanned 8 at a time when the cpu has avx2
+    template <size_t I>
+    std::vector<uint32_t> filter_range(const field_type<I>& lo,
+                                       const field_type<I>& hi) const {
+        const auto& data = column<I>();
+        std::vector<uint32_t> result(data.size());
+        size_t count{};
+        using T = field_type<I>;
+        if constexpr (std::is_integral_v<T> && std::is_signed_v<T> && sizeof(T) == 4) {
+            if (__builtin_cpu_supports("avx2")) {
+                count = filter_range_avx2(reinterpret_cast<const int32_t*>(data.data()),
+                                          data.size(), lo, hi, result.data());
+                result.resize(count);
+                return result;
+            }
+        }
+        for (size_t i{}; i < data.size(); i++) {
+            if (!(data[i] < lo) && !(hi < data[i])) result[count++] = static_cast<uint32_t>(i);
+        }
+        result.resize(count);
+        return result;
+    }
+
+    // the permutation that would stably sort the records by field I. only
+    // column I is read while sorting
+    template <size_t I, typename Compare = std::less<>>
+    std::vector<uint32_t> sort_permutation(Compare compare = Compare{}) const {
+        const auto& data = column<I>();
+        std::vector<uint32_t> permutation(data.size());
+        std::iota(permutation.begin(), permutation.end(), 0);
+        std::stable_sort(permutation.begin(), permutation.end(),
+            [&](uint32_t a, uint32_t b) { return compare(data[a], data[b]); });
+        return permutation;
+    }
+
+    // record i becomes the record previously at permutation[i]
+    void permute(const std::vector<uint32_t>& permutation) {
+        std::apply([&](auto&... column) { (gather(column, permutation), ...); }, columns);
+    }
+
+    template <size_t I, typename Compare = std::less<>>
+    void sort_by(Compare compare = Compare{}) {
+        permute(sort_permutation<I>(compare));
+    }
+
+private:
+    template <size_t... I>
+    void push_back(std::index_sequence<I...>, const Fields&... fields) {
+        (std::get<I>(columns).push_back(fields), ...);
+    }
+
+    template <typename T>
+    static void gather(std::vector<T>& column, const std::vector<uint32_t>& permutation) {
+        std::vector<T> sorted;
+        sorted.reserve(column.size());
+        for (auto i : permutation) sorted.push_back(std::move(column[i]));
+        column = std::move(sorted);
+    }
+};
+
+void trooper_soa() {
+    // field 0 is the prefix, field 1 the operating number
+    SoA<std::array<char, 2>, int> troopers;
+    troopers.push_back({ 'T', 'K' }, 421);
+    troopers.push_back({ 'F', 'N' }, 2187);
+    troopers.push_back({ 'L', 'S' }, 5);
+
+    troopers.sort_by<1>();
+    for (auto trooper : troopers) {
+        const auto& prefix = trooper.get<0>();
+        printf("stormtrooper %c%c-%d\n", prefix[0], prefix[1], trooper.get<1>());
+    }
+
+    // only the operating numbers are read by the scan
+    for (auto i : troopers.filter_range<1>(100, 3000)) {
+        printf("operating number in [100, 3000]: %d\n", troopers[i].get<1>());
+    }
+}
+
+// -------------------------------------------------------------------------------- 
+
 /*
  * const is a qualifier valid for:
  * function arguments; (the argument won't have its value changed)
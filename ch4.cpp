@@ -196,11 +196,15 @@ class SimpleString {
     char* buffer;
     size_t length;
 public:
+    // heap buffers allocated by all SimpleStrings, for benchmarking
+    static inline size_t allocations{};
+
     SimpleString(size_t max_size) : max_size{ max_size }, length {} {
         if (max_size == 0) {
             throw std::runtime_error{ "Max size must be at least 1." };
         }
         buffer = new char[max_size];
+        allocations++;
         buffer[0] = 0;
     }
 
@@ -210,6 +214,7 @@ public:
         buffer{ new char[other.max_size] },
         length{ other.length }
     {
+        allocations++;
         std::strncpy(buffer, other.buffer, max_size);
     }
 
@@ -219,6 +224,7 @@ public:
         if (this == &other) return *this;
         delete[] buffer;
         buffer = new char[other.max_size];
+        allocations++;
         length = other.length;
         max_size = other.max_size;
         std::strncpy(buffer, other.buffer, max_size);
@@ -568,4 +574,192 @@ void test_timer(void) {
     sleep(3);
 }
 
+// -------------------------------------------------------------------------------- 
+
+// small string optimization (SSO) and geometric growth
+// SimpleString above heap-allocates max_size bytes even for a one-word string,
+// can't grow past max_size and, on every append, strlen's the argument and
+// strncpy's it (which zero-pads the rest of the buffer!).
+// SmallString fixes these:
+// * strings of up to 22 chars live inside the object itself, no allocation
+// * when it must grow, capacity doubles, so n appends cost O(log n) allocations
+// * the length is cached, so appending costs O(appended), not O(length)
+
+#include <algorithm>
+
+class SmallString {
+public:
+    static constexpr size_t inline_capacity = 22;
+    // heap buffers allocated by all SmallStrings, for benchmarking
+    static inline size_t allocations{};
+
+    SmallString(void) : data{ local }, length{} {
+        local[0] = 0;
+    }
+
+    SmallString(const char* x) : SmallString{} {
+        append(x);
+    }
+
+    SmallString(const SmallString& other) : SmallString{} {
+        append(other.data, other.length);
+    }
+
+    SmallString& operator=(const SmallString& other) {
+        if (this == &other) return *this;
+        length = 0;
+        append(other.data, other.length);
+        return *this;
+    }
+
+    // an inline string has nothing to steal, so its bytes are copied
+    SmallString(SmallString&& other) noexcept : SmallString{} {
+        steal(other);
+    }
+
+    SmallString& operator=(SmallString&& other) noexcept {
+        if (this == &other) return *this;
+        if (!is_inline()) delete[] data;
+        data = local;
+        steal(other);
+        return *this;
+    }
+
+    ~SmallString(void) {
+        if (!is_inline()) delete[] data;
+    }
+
+    void append(const char* x, size_t x_len) {
+        reserve(length + x_len);
+        std::memcpy(data + length, x, x_len);
+        length += x_len;
+        data[length] = 0;
+    }
+
+    void append(const char* x) {
+        append(x, strlen(x));
+    }
+
+    void push_back(char c) {
+        reserve(length + 1);
+        data[length++] = c;
+        data[length] = 0;
+    }
+
+    // unlike SimpleString::append_line, never fails: the string grows instead
+    void append_line(const char* x) {
+        append(x);
+        push_back('\n');
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= capacity()) return;
+        new_capacity = std::max(new_capacity, 2 * capacity());
+        auto new_data = new char[new_capacity + 1];
+        allocations++;
+        std::memcpy(new_data, data, length + 1);
+        if (!is_inline()) delete[] data;
+        data = new_data;
+        heap_capacity = new_capacity;
+    }
+
+    void clear(void) {
+        length = 0;
+        data[0] = 0;
+    }
+
+    size_t size(void) const { return length; }
+    size_t capacity(void) const { return is_inline() ? inline_capacity : heap_capacity; }
+    bool is_inline(void) const { return data == local; }
+    const char* c_str(void) const { return data; }
+
+    void print(const char* tag) const {
+        printf("%s: %s", tag, data);
+    }
+
+private:
+    void steal(SmallString& other) {
+        length = other.length;
+        if (other.is_inline()) {
+            std::memcpy(local, other.local, length + 1);
+        } else {
+            data = other.data;
+            heap_capacity = other.heap_capacity;
+        }
+        other.data = other.local;
+        other.length = 0;
+        other.local[0] = 0;
+    }
+
+    char* data;     // either local or a heap buffer
+    size_t length;
+    // the heap capacity is only needed when the local buffer isn't in use
+    union {
+        size_t heap_capacity;
+        char local[inline_capacity + 1];
+    };
+};
+
+void small_string_usage(void) {
+    SmallString string;
+    string.append_line("Starbuck, whaddya hear?");
+    string.append_line("Nothin' but the rain.");
+    string.print("A");
+    string.append_line("Grab your gun and bring the cat in.");
+    string.append_line("Aye-aye sir, coming home.");
+    string.append_line("Galactica!");
+    string.print("B");
+    printf("Length %zu, capacity %zu\n", string.size(), string.capacity());
+}
+
+// benchmarking both strings for log-line building.
+// allocations are counted by the strings themselves (their static
+// allocations members), rather than by replacing the global operator new[].
+
+#include <chrono>
+
+template <typename Fn>
+void report(const char* name, size_t ops, const size_t& allocations, Fn fn) {
+    const auto allocations_before = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i{}; i < ops; i++) fn(i);
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    printf("%-40s %8.1f ns/op %7.4f allocs/op\n", name, ns / ops,
+           double(allocations - allocations_before) / ops);
+}
+
+void benchmark_log_lines(void) {
+    const size_t ops = 200'000;
+    const char* levels[]{ "INFO", "WARN", "ERROR" };
+    size_t sink{};
+
+    // a short line per op: fits SmallString's local buffer.
+    // SimpleString must still be sized for the longest line it may hold.
+    report("SimpleString, short line", ops, SimpleString::allocations, [&](size_t i) {
+        SimpleString line{ 128 };
+        line.append_line(levels[i % 3]);
+        sink += line.append_line("cache hit");
+    });
+    report("SmallString, short line", ops, SmallString::allocations, [&](size_t i) {
+        SmallString line;
+        line.append(levels[i % 3]);
+        line.append_line(" cache hit");
+        sink += line.size();
+    });
+
+    // a long log: SimpleString needs its final size up front, and every
+    // append strncpy-pads the remaining buffer, so each op is O(max_size).
+    const size_t lines = 20'000;
+    SimpleString log{ lines * 64 };
+    report("SimpleString, 20k-line log (per line)", lines, SimpleString::allocations, [&](size_t) {
+        sink += log.append_line("GET /index.html 200 OK from 10.0.0.1");
+    });
+    SmallString small_log;
+    report("SmallString, 20k-line log (per line)", lines, SmallString::allocations, [&](size_t) {
+        small_log.append_line("GET /index.html 200 OK from 10.0.0.1");
+    });
+    printf("(checksum %zu)\n", sink + small_log.size());
+}
+
 int main(void) {}